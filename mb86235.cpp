@@ -20,10 +20,10 @@
 #define ENABLE_DRC		1
 
 
+// defaults, MCFG_MB86235_CACHE_SIZE and MCFG_MB86235_COMPILE_WINDOW override them
 #define CACHE_SIZE                      (1 * 1024 * 1024)
 #define COMPILE_BACKWARDS_BYTES         128
 #define COMPILE_FORWARDS_BYTES          512
-#define COMPILE_MAX_INSTRUCTIONS        ((COMPILE_BACKWARDS_BYTES/4) + (COMPILE_FORWARDS_BYTES/4))
 #define COMPILE_MAX_SEQUENCE            64
 
 
@@ -47,7 +47,7 @@ void mb86235_device::execute_run()
 #if ENABLE_DRC
 	run_drc();
 #else
-	m_core->icount = 0;
+	run_interpreter();
 #endif
 }
 
@@ -59,13 +59,35 @@ void mb86235_device::device_start()
 	m_dataa = &space(AS_DATA);
 	m_datab = &space(AS_IO);
 
-	m_core = (mb86235_internal_state *)m_cache.alloc_near(sizeof(mb86235_internal_state));
+	// the program fingerprint covers everything mapped to memory in the program space
+	for (address_map_entry *entry = m_program->map()->m_entrylist.first(); entry != nullptr; entry = entry->next())
+	{
+		map_handler_type type = entry->m_read.m_type;
+		if (type == AMH_RAM || type == AMH_ROM || type == AMH_BANK)
+			m_program_ranges.push_back(std::make_pair(entry->m_addrstart, entry->m_addrend));
+	}
+
+	// the generated code reads and writes the internal RAM directly when it is one plain block of RAM
+	m_internal_ram[0] = (uint32_t *)m_dataa->get_write_ptr(0);
+	m_internal_ram[1] = (uint32_t *)m_datab->get_write_ptr(0);
+	for (int bank = 0; bank < 2; bank++)
+	{
+		address_space *space = bank ? m_datab : m_dataa;
+		offs_t last = (INTERNAL_RAM_WORDS - 1) << 2;
+		uint32_t *base = m_internal_ram[bank];
+		if (base != nullptr && (space->get_read_ptr(0) != base ||
+			space->get_read_ptr(last) != base + INTERNAL_RAM_WORDS - 1 || space->get_write_ptr(last) != base + INTERNAL_RAM_WORDS - 1))
+			m_internal_ram[bank] = nullptr;
+	}
+
+	m_cache = std::make_unique<drc_cache>(m_cache_size + sizeof(mb86235_internal_state));
+	m_core = (mb86235_internal_state *)m_cache->alloc_near(sizeof(mb86235_internal_state));
 	memset(m_core, 0, sizeof(mb86235_internal_state));
 
 
 	// init UML generator
 	uint32_t umlflags = 0;
-	m_drcuml = std::make_unique<drcuml_state>(*this, m_cache, umlflags, 1, 24, 0);
+	m_drcuml = std::make_unique<drcuml_state>(*this, *m_cache, umlflags, 1, 24, 0);
 
 	// add UML symbols
 	m_drcuml->symbol_add(&m_core->pc, sizeof(m_core->pc), "pc");
@@ -86,20 +108,7 @@ void mb86235_device::device_start()
 		m_drcuml->symbol_add(&m_core->ar[i], sizeof(m_core->ar[i]), buf);
 	}
 
-	m_drcuml->symbol_add(&m_core->flags.az, sizeof(m_core->flags.az), "flags_az");
-	m_drcuml->symbol_add(&m_core->flags.an, sizeof(m_core->flags.an), "flags_an");
-	m_drcuml->symbol_add(&m_core->flags.av, sizeof(m_core->flags.av), "flags_av");
-	m_drcuml->symbol_add(&m_core->flags.au, sizeof(m_core->flags.au), "flags_au");
-	m_drcuml->symbol_add(&m_core->flags.ad, sizeof(m_core->flags.ad), "flags_ad");
-	m_drcuml->symbol_add(&m_core->flags.zc, sizeof(m_core->flags.zc), "flags_zc");
-	m_drcuml->symbol_add(&m_core->flags.il, sizeof(m_core->flags.il), "flags_il");
-	m_drcuml->symbol_add(&m_core->flags.nr, sizeof(m_core->flags.nr), "flags_nr");
-	m_drcuml->symbol_add(&m_core->flags.zd, sizeof(m_core->flags.zd), "flags_zd");
-	m_drcuml->symbol_add(&m_core->flags.mn, sizeof(m_core->flags.mn), "flags_mn");
-	m_drcuml->symbol_add(&m_core->flags.mz, sizeof(m_core->flags.mz), "flags_mz");
-	m_drcuml->symbol_add(&m_core->flags.mv, sizeof(m_core->flags.mv), "flags_mv");
-	m_drcuml->symbol_add(&m_core->flags.mu, sizeof(m_core->flags.mu), "flags_mu");
-	m_drcuml->symbol_add(&m_core->flags.md, sizeof(m_core->flags.md), "flags_md");
+	m_drcuml->symbol_add(&m_core->st, sizeof(m_core->st), "st");
 
 
 	m_drcuml->symbol_add(&m_core->arg0, sizeof(m_core->arg0), "arg0");
@@ -112,15 +121,11 @@ void mb86235_device::device_start()
 	m_drcuml->symbol_add(&m_core->pcs_ptr, sizeof(m_core->pcs_ptr), "pcs_ptr");
 
 
-	m_drcfe = std::make_unique<mb86235_frontend>(this, COMPILE_BACKWARDS_BYTES, COMPILE_FORWARDS_BYTES, COMPILE_MAX_SEQUENCE);
+	m_drcfe = std::make_unique<mb86235_frontend>(this, m_compile_backwards, m_compile_forwards, m_compile_max_sequence);
 
-	for (int i = 0; i < 8; i++)
-	{
-		m_regmap[i] = uml::mem(&m_core->aa[i]);
-		m_regmap[i + 8] = uml::mem(&m_core->ab[i]);
-		m_regmap[i + 16] = uml::mem(&m_core->ma[i]);
-		m_regmap[i + 24] = uml::mem(&m_core->mb[i]);
-	}
+	memset(m_reguse, 0, sizeof(m_reguse));
+	memset(&m_stats, 0, sizeof(m_stats));
+	assign_fast_iregs();
 
 
 	// Register state for debugger
@@ -165,6 +170,7 @@ void mb86235_device::device_start()
 	state_add(MB86235_MB5, "MB5", m_core->mb[5]).formatstr("%08X");
 	state_add(MB86235_MB6, "MB6", m_core->mb[6]).formatstr("%08X");
 	state_add(MB86235_MB7, "MB7", m_core->mb[7]).formatstr("%08X");
+	state_add(MB86235_ST, "ST", m_core->st).formatstr("%04X").callimport().callexport();
 	state_add(STATE_GENPC, "GENPC", m_core->pc ).noshow();
 	state_add(STATE_GENPCBASE, "CURPC", m_core->pc).noshow();
 
@@ -175,11 +181,22 @@ void mb86235_device::device_start()
 
 void mb86235_device::device_reset()
 {
-	flush_cache();
+	reset_decode_cache();
+
+	// the program may not be uploaded yet, so whether the compiled code is still good is decided at the first execution
+	m_reset_check_pending = true;
 
 	m_core->pc = 0;
 }
 
+void mb86235_device::device_stop()
+{
+	if (m_cache_dir != nullptr)
+		save_block_list();
+
+	report_cache_stats();
+}
+
 #if 0
 void mb86235_cpu_device::execute_set_input(int irqline, int state)
 {
@@ -208,13 +225,48 @@ mb86235_device::mb86235_device(const machine_config &mconfig, const char *tag, d
 	, m_program_config("program", ENDIANNESS_LITTLE, 64, 32, -3)
 	, m_dataa_config("data_a", ENDIANNESS_LITTLE, 32, 24, -2, ADDRESS_MAP_NAME(internal_abus))
 	, m_datab_config("data_b", ENDIANNESS_LITTLE, 32, 10, -2, ADDRESS_MAP_NAME(internal_bbus))
-	, m_cache(CACHE_SIZE + sizeof(mb86235_internal_state))
+	, m_cache(nullptr)
 	, m_drcuml(nullptr)
 	, m_drcfe(nullptr)
+	, m_fifo_trace(false)
+	, m_cache_dirty(false)
+	, m_cache_dir(nullptr)
+	, m_block_pcs_fingerprint(0)
+	, m_reset_fingerprint(0)
+	, m_reset_fingerprint_valid(false)
+	, m_reset_check_pending(false)
+	, m_flush_count(0)
+	, m_cache_full_count(0)
+	, m_refill_pending(false)
+	, m_cache_size(CACHE_SIZE)
+	, m_compile_backwards(COMPILE_BACKWARDS_BYTES)
+	, m_compile_forwards(COMPILE_FORWARDS_BYTES)
+	, m_compile_max_sequence(COMPILE_MAX_SEQUENCE)
 {
 }
 
 
+void mb86235_device::state_import(const device_state_entry &entry)
+{
+	switch (entry.index())
+	{
+		case MB86235_ST:
+			// the written value replaces any flags still pending from the last ALU/MUL op
+			drop_lazy_flags();
+			break;
+	}
+}
+
+void mb86235_device::state_export(const device_state_entry &entry)
+{
+	switch (entry.index())
+	{
+		case MB86235_ST:
+			materialize_lazy_flags();
+			break;
+	}
+}
+
 void mb86235_device::state_string_export(const device_state_entry &entry, std::string &str) const
 {
 	switch (entry.index())
@@ -234,40 +286,35 @@ offs_t mb86235_device::disasm_disassemble(std::ostream &stream, offs_t pc, const
 
 void mb86235_device::fifoin_w(uint64_t data)
 {
-#if ENABLE_DRC
 	if (m_core->fifoin.num >= FIFOIN_SIZE)
 	{
 		fatalerror("fifoin_w: pushing to full fifo");
 	}
 
-	printf("FIFOIN push %08X%08X (wpos %04X)\n", (uint32_t)(data >> 32), (uint32_t)(data), m_core->fifoin.wpos);
+	if (m_fifo_trace)
+		logerror("FIFOIN push %08X%08X (wpos %04X)\n", (uint32_t)(data >> 32), (uint32_t)(data), m_core->fifoin.wpos);
 
 	m_core->fifoin.data[m_core->fifoin.wpos] = data;
 	
 	m_core->fifoin.wpos++;
 	m_core->fifoin.wpos &= FIFOIN_SIZE-1;
 	m_core->fifoin.num++;
-#endif
 }
 
 bool mb86235_device::is_fifoin_full()
 {
-#if ENABLE_DRC
 	return m_core->fifoin.num >= FIFOIN_SIZE;
-#else
-	return false;
-#endif
 }
 
 uint64_t mb86235_device::fifoout0_r()
 {
-#if ENABLE_DRC
 	if (m_core->fifoout0.num == 0)
 	{
 		fatalerror("fifoout0_r: reading from empty fifo");
 	}
 
-	printf("FIFOOUT read (rpos %04X)\n", m_core->fifoout0.rpos);
+	if (m_fifo_trace)
+		logerror("FIFOOUT read (rpos %04X)\n", m_core->fifoout0.rpos);
 
 	uint64_t data = m_core->fifoout0.data[m_core->fifoout0.rpos];
 
@@ -275,16 +322,9 @@ uint64_t mb86235_device::fifoout0_r()
 	m_core->fifoout0.rpos &= FIFOOUT0_SIZE - 1;
 	m_core->fifoout0.num--;
 	return data;
-#else
-	return 0;
-#endif
 }
 
 bool mb86235_device::is_fifoout0_empty()
 {
-#if ENABLE_DRC
 	return m_core->fifoout0.num == 0;
-#else
-	return false;
-#endif
 }
\ No newline at end of file
@@ -17,6 +17,16 @@
 class mb86235_frontend;
 
 
+#define MCFG_MB86235_CACHE_DIRECTORY(_dir) \
+	mb86235_device::static_set_cache_directory(*device, _dir);
+
+#define MCFG_MB86235_CACHE_SIZE(_bytes) \
+	mb86235_device::static_set_cache_size(*device, _bytes);
+
+#define MCFG_MB86235_COMPILE_WINDOW(_backwards, _forwards, _max_sequence) \
+	mb86235_device::static_set_compile_window(*device, _backwards, _forwards, _max_sequence);
+
+
 
 
 #define OP_USERFLAG_FIFOIN				0x1
@@ -32,6 +42,26 @@ class mb86235_frontend;
 #define OP_USERFLAG_PW_INC				0x400
 #define OP_USERFLAG_PW_DEC				0x800
 #define OP_USERFLAG_PW_ZERO				0xc00
+#define OP_USERFLAG_LPC					0x1000
+#define OP_USERFLAG_FIFO_CLEAR			0x2000
+
+// status register (ST) bits, in the same order as the frontend flag usage bits
+#define ST_AZ							0x0001
+#define ST_AN							0x0002
+#define ST_AV							0x0004
+#define ST_AU							0x0008
+#define ST_AD							0x0010
+#define ST_ZC							0x0020
+#define ST_IL							0x0040
+#define ST_NR							0x0080
+#define ST_ZD							0x0100
+#define ST_MN							0x0200
+#define ST_MZ							0x0400
+#define ST_MV							0x0800
+#define ST_MU							0x1000
+#define ST_MD							0x2000
+#define ST_LP							0x4000
+#define ST_RP							0x8000
 
 
 class mb86235_device :  public cpu_device
@@ -42,6 +72,17 @@ public:
 	// construction/destruction
 	mb86235_device(const machine_config &mconfig, const char *_tag, device_t *_owner, uint32_t clock);
 
+	// static configuration helpers
+	static void static_set_cache_directory(device_t &device, const char *dir) { downcast<mb86235_device &>(device).m_cache_dir = dir; }
+	static void static_set_cache_size(device_t &device, size_t bytes) { downcast<mb86235_device &>(device).m_cache_size = bytes; }
+	static void static_set_compile_window(device_t &device, uint32_t backwards, uint32_t forwards, uint32_t max_sequence)
+	{
+		mb86235_device &dev = downcast<mb86235_device &>(device);
+		dev.m_compile_backwards = backwards;
+		dev.m_compile_forwards = forwards;
+		dev.m_compile_max_sequence = max_sequence;
+	}
+
 	void unimplemented_op();
 	void unimplemented_alu();
 	void unimplemented_control();
@@ -50,6 +91,15 @@ public:
 	void pcs_overflow();
 	void pcs_underflow();
 	void fifoin_trace();
+	void external_burst_read();
+	void external_burst_write();
+
+	// FIFO tracing goes to the error log, compiled code only contains it while enabled
+	void set_fifo_trace(bool enable);
+
+	// tell the core that program memory between two instruction addresses was rewritten,
+	// nothing watches the program space so drivers must call this after writing to it
+	void invalidate_code(offs_t start, offs_t end);
 
 	void fifoin_w(uint64_t data);
 	bool is_fifoin_full();
@@ -64,16 +114,19 @@ public:
 		MB86235_MA0, MB86235_MA1, MB86235_MA2, MB86235_MA3, MB86235_MA4, MB86235_MA5, MB86235_MA6, MB86235_MA7,
 		MB86235_MB0, MB86235_MB1, MB86235_MB2, MB86235_MB3, MB86235_MB4, MB86235_MB5, MB86235_MB6, MB86235_MB7,
 		MB86235_AR0, MB86235_AR1, MB86235_AR2, MB86235_AR3, MB86235_AR4, MB86235_AR5, MB86235_AR6, MB86235_AR7,
+		MB86235_ST,
 	};
 
 	const int FIFOIN_SIZE = 128;
 	const int FIFOOUT0_SIZE = 128;
 	const int FIFOOUT1_SIZE = 128;
+	const int INTERNAL_RAM_WORDS = 0x400;
 
 protected:
 	// device-level overrides
 	virtual void device_start() override;
 	virtual void device_reset() override;
+	virtual void device_stop() override;
 
 	// device_execute_interface overrides
 	virtual uint32_t execute_min_cycles() const override { return 1; }
@@ -86,6 +139,8 @@ protected:
 	virtual const address_space_config *memory_space_config(address_spacenum spacenum = AS_0) const override { return (spacenum == AS_PROGRAM) ? &m_program_config : ((spacenum == AS_DATA) ? &m_dataa_config : (spacenum == AS_IO) ? &m_datab_config : nullptr); }
 
 	// device_state_interface overrides
+	virtual void state_import(const device_state_entry &entry) override;
+	virtual void state_export(const device_state_entry &entry) override;
 	virtual void state_string_export(const device_state_entry &entry, std::string &str) const override;
 
 	// device_disasm_interface overrides
@@ -97,26 +152,6 @@ protected:
 
 private:
 
-	struct mb86235_flags
-	{
-		uint32_t az;
-		uint32_t an;
-		uint32_t av;
-		uint32_t au;
-		uint32_t ad;
-		uint32_t zc;
-		uint32_t il;
-		uint32_t nr;
-		uint32_t zd;
-		uint32_t mn;
-		uint32_t mz;
-		uint32_t mv;
-		uint32_t mu;
-		uint32_t md;
-		uint32_t lp;
-		uint32_t rp;
-	};
-
 	struct fifo
 	{
 		int rpos;
@@ -145,7 +180,11 @@ private:
 		uint32_t pr[24];
 
 		uint32_t mod;
-		mb86235_flags flags;
+		uint32_t st;
+		uint32_t alures;
+		uint32_t alukind;
+		uint32_t mulres;
+		uint32_t mulkind;
 
 		int icount;
 
@@ -162,9 +201,13 @@ private:
 		uint32_t alutemp;
 		uint32_t multemp;
 		uint32_t condtemp;
+		uint32_t repcount;
 
 		uint32_t pdr;
 		uint32_t ddr;
+		uint32_t icdtr[8];
+
+		uint32_t burst[16];                          /* external transfers batched by the compiler */
 
 		float fp0;
 
@@ -175,22 +218,83 @@ private:
 
 	mb86235_internal_state  *m_core;
 
-	uml::parameter   m_regmap[32];
+	uml::parameter   m_regmap[33];                 /* AA/AB/MA/MB, then LPC */
+	uint32_t         m_reguse[33];
+
+	bool m_fifo_trace;
+	bool m_cache_dirty;
+
+	// block list kept across runs, to prebuild the blocks of a known program
+	const char *m_cache_dir;
+	std::vector<offs_t> m_block_pcs;
+	uint64_t m_block_pcs_fingerprint;              /* program the recorded pcs were compiled from */
+
+	// word ranges of the program space backed by RAM, ROM or banks
+	std::vector<std::pair<offs_t, offs_t>> m_program_ranges;
+
+	// program fingerprint at the first execution after the last reset, the cache is kept while it matches
+	uint64_t m_reset_fingerprint;
+	bool m_reset_fingerprint_valid;
+	bool m_reset_check_pending;
+
+	// static exits of the last compiled block, to compile ahead
+	std::vector<offs_t> m_successors;
+	uint32_t m_flush_count;
+
+	// flushes caused by a full cache, and the hot blocks still to bring back after one
+	uint32_t m_cache_full_count;
+	bool m_refill_pending;
+
+	// code cache size and compile window, set by the machine configuration
+	size_t m_cache_size;
+	uint32_t m_compile_backwards;
+	uint32_t m_compile_forwards;
+	uint32_t m_compile_max_sequence;
+
+	// compiler statistics, for the sizing advice at exit
+	struct compile_stats
+	{
+		uint64_t blocks;                             /* blocks compiled */
+		uint64_t code_bytes;                         /* code generated by them */
+		uint64_t sequences;                          /* sequences in them */
+		uint32_t max_span;                           /* largest pc range of a block */
+		uint32_t max_sequence;                       /* longest sequence */
+		size_t   high_water;                         /* most of the cache in use at once */
+	};
+	compile_stats m_stats;
+
+	// entry counts of compiled blocks, by start pc; nodes don't move, the code counts in place
+	struct block_profile
+	{
+		uint32_t count;
+		bool hot;
+	};
+	std::unordered_map<offs_t, block_profile> m_profile;
+
+	// rewrite count of each program page compiled code was read from, checked in place by the code
+	std::unordered_map<uint32_t, uint32_t> m_code_generation;
+
+	// state of the block being compiled: the program pages it depends on, and the flags
+	// each instruction must compute
+	std::vector<uint32_t> m_block_pages;
+	std::unordered_map<const opcode_desc *, uint32_t> m_flagreq;
 
 	uml::code_handle *m_entry;                      /* entry point */
 	uml::code_handle *m_nocode;                     /* nocode exception handler */
 	uml::code_handle *m_out_of_cycles;              /* out of cycles exception handler */
+	uml::code_handle *m_invalidated_code;           /* rewritten code exception handler */
 	uml::code_handle *m_clear_fifo_in;
 	uml::code_handle *m_clear_fifo_out0;
 	uml::code_handle *m_clear_fifo_out1;
-	uml::code_handle *m_read_fifo_in;
-	uml::code_handle *m_write_fifo_out0;
-	uml::code_handle *m_write_fifo_out1;
+	uml::code_handle *m_read_ram[2];                /* RAM-A/RAM-B readers, I0 = word address, result in I1 */
+	uml::code_handle *m_write_ram[2];               /* RAM-A/RAM-B writers, I0 = word address, I1 = data */
+
+	uint32_t *m_internal_ram[2];                    /* host pointers to the internal RAM of both buses, if mapped as RAM */
 
 	address_space_config m_program_config;
 	address_space_config m_dataa_config;
 	address_space_config m_datab_config;
-	drc_cache m_cache;
+	std::unique_ptr<drc_cache> m_cache;
 	std::unique_ptr<drcuml_state> m_drcuml;
 	std::unique_ptr<mb86235_frontend> m_drcfe;
 
@@ -204,33 +308,132 @@ private:
 		uint32_t cycles;                             /* accumulated cycles */
 		uint8_t  checkints;                          /* need to check interrupts before next instruction */
 		uml::code_label  labelnum;                 /* index for local labels */
+		uint32_t flagreq;                            /* flags this instruction must compute */
+		uint8_t  fifo_guarded;                       /* FIFO accesses were checked at the sequence head */
+		int32_t  prp;                                /* PRP value if known at compile time, -1 otherwise */
+		int32_t  pwp;                                /* PWP value if known at compile time, -1 otherwise */
+		int32_t  alukind;                            /* lazy ALU flag kind if known at compile time, -1 otherwise */
+		int32_t  mulkind;                            /* lazy MUL flag kind if known at compile time, -1 otherwise */
+		uint8_t  hot;                                /* compiling a hot block with the expensive passes */
+		uint32_t splitpc;                            /* first pc left out of a block compiled in parts */
+		uint8_t  arknown;                            /* AR registers whose value is known at compile time */
+		uint32_t ar[8];                              /* their values */
+		uint8_t  eaknown;                            /* the last generate_ea was folded to a constant */
+		uint32_t ea;                                 /* and its address */
+		uint8_t  burst_count;                        /* external transfers in the current burst, 0 if none */
+		uint8_t  burst_index;                        /* position in it */
 	};
 
+	/* predecoded instruction for the interpreter */
+	struct decoded_op
+	{
+		uint64_t opcode;
+		uint32_t pc;                                 /* pc this slot holds */
+		uint32_t targetpc;                           /* static branch target, or BRANCH_TARGET_DYNAMIC */
+		uint32_t aluop;
+		uint32_t mulop;
+		uint32_t userflags;
+		uint8_t  type;                               /* opcode bits 61-63 */
+		uint8_t  flags;                              /* DECODED_* */
+		uint8_t  cycles;
+		uint8_t  fifoin;                             /* FIFO accesses, including the delay slot */
+		uint8_t  fifoout0;
+		uint8_t  fifoout1;
+	};
+
+	// interpreter
+	std::vector<decoded_op> m_decode;
+
+	void run_interpreter();
+	void reset_decode_cache();
+	void invalidate_decode_cache(offs_t start, offs_t end);
+	const decoded_op &decode_op(uint32_t pc);
+	bool fifo_ready(const decoded_op &op);
+	void execute_repeat(const decoded_op &op);
+	uint32_t execute_op(const decoded_op &op);
+	void execute_alu(const decoded_op &op, uint32_t *dst);
+	void execute_mul(const decoded_op &op, uint32_t *dst);
+	bool execute_control(const decoded_op &op, uint32_t condflags);
+	void execute_xfer1(const decoded_op &op);
+	void execute_xfer2(const decoded_op &op);
+	void execute_double_xfer1(const decoded_op &op);
+	void execute_double_xfer2(const decoded_op &op);
+	uint32_t double_xfer_source(int sd, int reg, int md, int arx, int ary, int bank);
+	void double_xfer_dest(int sd, int reg, int md, int arx, int ary, int bank, uint32_t data);
+	void execute_xfer3(const decoded_op &op);
+	uint32_t read_fifo_in();
+	void write_fifo_out0(uint32_t data);
+	uint32_t read_reg(int reg);
+	void write_reg(int reg, uint32_t data);
+	uint32_t read_alumul_input(int reg, bool fp, bool mul);
+	uint32_t *alu_output(int reg);
+	uint32_t calc_ea(int md, int arx, int ary, int disp);
+	void step_pr(bool pw, int mode);
+
 	void run_drc();
+	void materialize_lazy_flags();
+	void drop_lazy_flags();
 	void flush_cache();
 	void alloc_handle(drcuml_state *drcuml, uml::code_handle **handleptr, const char *name);
-	void compile_block(offs_t pc);
+	void compile_block(offs_t pc, bool speculative = false);
+	void compile_ahead();
+	void refill_cache();
+	void report_cache_stats();
+	uint64_t program_fingerprint();
+	bool program_mapped(offs_t pc);
+	void load_block_list(uint64_t hash);
+	bool read_block_list(uint64_t hash, std::vector<uint32_t> &pcs);
+	void save_block_list();
+	void assign_fast_iregs();
+	uml::parameter get_reg_memory(int regnum);
 	void load_fast_iregs(drcuml_block *block);
 	void save_fast_iregs(drcuml_block *block);
 	void static_generate_entry_point();
 	void static_generate_nocode_handler();
 	void static_generate_out_of_cycles();
+	void static_generate_invalidated_code();
 	void static_generate_fifo();
 	void static_generate_memory_accessors();
 	void generate_sequence_instruction(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc);
+	void generate_read_fifo_in(drcuml_block *block, uml::parameter dst);
+	void generate_write_fifo_out0(drcuml_block *block, uml::parameter src);
+	void generate_pr_read(drcuml_block *block, compiler_state *compiler, uml::parameter dst);
+	void generate_pr_write(drcuml_block *block, compiler_state *compiler, uml::parameter src);
+	void generate_pr_update(drcuml_block *block, compiler_state *compiler, bool pw, int mode);
+	void generate_repeat_start(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, uml::code_label loop);
+	void generate_repeat_end(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, uml::code_label loop);
+	void generate_push_pc(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc);
+	void generate_pop_pc(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc);
+	void generate_static_jump(drcuml_block *block, compiler_state *compiler, const opcode_desc *desclist, offs_t pc);
+	void generate_fifo_guard(drcuml_block *block, int fifoin, int fifoout0, int fifoout1, uml::code_label fail);
+	void generate_code_check(drcuml_block *block, compiler_state *compiler, offs_t pc);
 	void generate_update_cycles(drcuml_block *block, compiler_state *compiler, uml::parameter param, bool allow_exception);
 	bool generate_opcode(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc);
 	void generate_alu(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int aluop, bool alu_temp);
 	void generate_mul(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int mulop, bool mul_temp);
+	void generate_update_flags(drcuml_block *block, uint32_t mask, uml::condition_t ncond, uint32_t nflag, uml::condition_t zcond, uint32_t zflag, uint32_t vflag, uint32_t setflags);
+	void generate_set_overflow(drcuml_block *block, uint32_t flag);
+	void generate_saturate(drcuml_block *block, bool overflow);
+	void generate_lazy_flags(drcuml_block *block, compiler_state *compiler, bool mul, int kind, uml::parameter result, uint32_t mask);
+	void generate_clear_lazy_flags(drcuml_block *block, compiler_state *compiler, bool mul, uint32_t mask);
+	void generate_materialize_flags(drcuml_block *block, compiler_state *compiler, bool mul, uint32_t mask);
 	void generate_pre_control(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc);
 	void generate_control(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc);
+	bool external_xfer_info(const opcode_desc *desc, int *dir, int32_t *disp);
+	int external_burst_length(const opcode_desc *desc);
+	void generate_external_xfer(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int dir, int32_t disp);
 	void generate_xfer1(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc);
 	void generate_double_xfer1(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc);
 	void generate_xfer2(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc);
 	void generate_double_xfer2(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc);
+	void generate_double_xfer_source(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int sd, int reg, int md, int arx, int ary, int bank);
+	void generate_double_xfer_dest(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int sd, int reg, int md, int arx, int ary, int bank, uml::parameter src);
 	void generate_xfer3(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc);
 	void generate_branch(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc);
 	void generate_ea(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int md, int arx, int ary, int disp);
+	void generate_ar_add(drcuml_block *block, compiler_state *compiler, int reg, int32_t value);
+	void generate_ram_read(drcuml_block *block, compiler_state *compiler, int bank);
+	void generate_ram_write(drcuml_block *block, compiler_state *compiler, int bank, uml::parameter src);
 	void generate_reg_read(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int reg, uml::parameter dst);
 	void generate_reg_write(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int reg, uml::parameter src);
 	void generate_alumul_input(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int reg, uml::parameter dst, bool fp, bool mul);
@@ -27,6 +27,45 @@
 using namespace uml;
 
 
+// compile-time options
+#define DISABLE_FAST_REGISTERS          0
+#define DISABLE_LAZY_FLAGS              0
+#define DISABLE_FLAG_LIVENESS           0
+#define DISABLE_FIFO_GUARD              0
+#define DISABLE_PR_TRACKING             0
+#define DISABLE_AR_TRACKING             0
+#define DISABLE_EXTERNAL_BURST          0
+#define DISABLE_CODE_INVALIDATION       0
+
+// how many successor blocks to compile at the end of a timeslice, 0 to only compile what is needed
+#define COMPILE_AHEAD_BLOCKS            4
+#define COMPILE_AHEAD_SUCCESSORS        32
+// part of the cache (1/n) left free by compiling ahead
+#define COMPILE_AHEAD_CACHE_RESERVE     4
+
+// how many of the most used blocks to compile again right after the cache fills up
+#define CACHE_REFILL_BLOCKS             64
+
+// entries after which a block is recompiled with the expensive passes, 0 to disable
+#define HOT_BLOCK_THRESHOLD             2000
+#define HOT_BLOCK_REGUSE_WEIGHT         64
+
+// UML instructions reserved for each generated copy of an instruction, not counting fast register
+// spills, and for the head and exit of each sequence and the block
+#define UML_PER_INSTRUCTION             64
+#define UML_PER_SEQUENCE                32
+#define UML_PER_BLOCK                   256
+
+// block list file
+#define BLOCK_LIST_MAGIC                0x4c383842          // 'B88L'
+#define BLOCK_LIST_VERSION              1
+#define BLOCK_LIST_MAX                  4096
+
+// I0-I2 are scratch registers for the generated code and static handlers,
+// everything above that is available for pinning AA/AB/MA/MB
+#define FIRST_FAST_IREG                 3
+
+
 // map variables
 #define MAPVAR_PC                       M0
 #define MAPVAR_CYCLES                   M1
@@ -36,6 +75,9 @@ using namespace uml;
 #define EXECUTE_MISSING_CODE            1
 #define EXECUTE_UNMAPPED_CODE           2
 #define EXECUTE_RESET_CACHE             3
+#define EXECUTE_HOT_BLOCK               4
+#define EXECUTE_INVALIDATED_CODE        5
+
 
 
 #define AR(reg)					mem(&m_core->ar[(reg)])
@@ -43,42 +85,39 @@ using namespace uml;
 #define AB(reg)					m_regmap[(reg)+8]
 #define MA(reg)					m_regmap[(reg)+16]
 #define MB(reg)					m_regmap[(reg)+24]
-#define FLAGS_AZ				mem(&m_core->flags.az)
-#define FLAGS_AN				mem(&m_core->flags.an)
-#define FLAGS_AV				mem(&m_core->flags.av)
-#define FLAGS_AU				mem(&m_core->flags.au)
-#define FLAGS_AD				mem(&m_core->flags.ad)
-#define FLAGS_ZC				mem(&m_core->flags.zc)
-#define FLAGS_IL				mem(&m_core->flags.il)
-#define FLAGS_NR				mem(&m_core->flags.nr)
-#define FLAGS_ZD				mem(&m_core->flags.zd)
-#define FLAGS_MN				mem(&m_core->flags.mn)
-#define FLAGS_MZ				mem(&m_core->flags.mz)
-#define FLAGS_MV				mem(&m_core->flags.mv)
-#define FLAGS_MU				mem(&m_core->flags.mu)
-#define FLAGS_MD				mem(&m_core->flags.md)
-#define FLAGS_LP				mem(&m_core->flags.lp)
-#define FLAGS_RP				mem(&m_core->flags.rp)
+#define REGMAP_LPC				32
+#define FLAGS_ST				mem(&m_core->st)
+#define ALURES					mem(&m_core->alures)
+#define ALUKIND					mem(&m_core->alukind)
+#define MULRES					mem(&m_core->mulres)
+#define MULKIND					mem(&m_core->mulkind)
+
+// lazy flag result kinds
+#define LAZY_FLAGS_NONE			0			// ST is up to date
+#define LAZY_FLAGS_INT			1			// N/Z come from a signed integer result
+#define LAZY_FLAGS_FP			2			// N/Z come from a float result
 
 #define PRP						mem(&m_core->prp)
 #define PWP						mem(&m_core->pwp)
 #define RPC						mem(&m_core->rpc)
-#define LPC						mem(&m_core->lpc)
-
-#define AZ_CALC_REQUIRED		((desc->regreq[1] & 0x1) || desc->flags & OPFLAG_IN_DELAY_SLOT)
-#define AN_CALC_REQUIRED		((desc->regreq[1] & 0x2) || desc->flags & OPFLAG_IN_DELAY_SLOT)
-#define AV_CALC_REQUIRED		((desc->regreq[1] & 0x4) || desc->flags & OPFLAG_IN_DELAY_SLOT)
-#define AU_CALC_REQUIRED		((desc->regreq[1] & 0x8) || desc->flags & OPFLAG_IN_DELAY_SLOT)
-#define AD_CALC_REQUIRED		((desc->regreq[1] & 0x10) || desc->flags & OPFLAG_IN_DELAY_SLOT)
-#define ZC_CALC_REQUIRED		((desc->regreq[1] & 0x20) || desc->flags & OPFLAG_IN_DELAY_SLOT)
-#define IL_CALC_REQUIRED		((desc->regreq[1] & 0x40) || desc->flags & OPFLAG_IN_DELAY_SLOT)
-#define NR_CALC_REQUIRED		((desc->regreq[1] & 0x80) || desc->flags & OPFLAG_IN_DELAY_SLOT)
-#define ZD_CALC_REQUIRED		((desc->regreq[1] & 0x100) || desc->flags & OPFLAG_IN_DELAY_SLOT)
-#define MN_CALC_REQUIRED		((desc->regreq[1] & 0x200) || desc->flags & OPFLAG_IN_DELAY_SLOT)
-#define MZ_CALC_REQUIRED		((desc->regreq[1] & 0x400) || desc->flags & OPFLAG_IN_DELAY_SLOT)
-#define MV_CALC_REQUIRED		((desc->regreq[1] & 0x800) || desc->flags & OPFLAG_IN_DELAY_SLOT)
-#define MU_CALC_REQUIRED		((desc->regreq[1] & 0x1000) || desc->flags & OPFLAG_IN_DELAY_SLOT)
-#define MD_CALC_REQUIRED		((desc->regreq[1] & 0x2000) || desc->flags & OPFLAG_IN_DELAY_SLOT)
+#define LPC						m_regmap[REGMAP_LPC]
+
+#define AZ_CALC_REQUIRED		(compiler->flagreq & 0x1)
+#define AN_CALC_REQUIRED		(compiler->flagreq & 0x2)
+#define AV_CALC_REQUIRED		(compiler->flagreq & 0x4)
+#define AU_CALC_REQUIRED		(compiler->flagreq & 0x8)
+#define AD_CALC_REQUIRED		(compiler->flagreq & 0x10)
+#define ZC_CALC_REQUIRED		(compiler->flagreq & 0x20)
+#define IL_CALC_REQUIRED		(compiler->flagreq & 0x40)
+#define NR_CALC_REQUIRED		(compiler->flagreq & 0x80)
+#define ZD_CALC_REQUIRED		(compiler->flagreq & 0x100)
+#define MN_CALC_REQUIRED		(compiler->flagreq & 0x200)
+#define MZ_CALC_REQUIRED		(compiler->flagreq & 0x400)
+#define MV_CALC_REQUIRED		(compiler->flagreq & 0x800)
+#define MU_CALC_REQUIRED		(compiler->flagreq & 0x1000)
+#define MD_CALC_REQUIRED		(compiler->flagreq & 0x2000)
+
+#define FLAG_IF_REQUIRED(f)		(f##_CALC_REQUIRED ? ST_##f : 0)
 
 #define FIFOIN_RPOS				mem(&m_core->fifoin.rpos)
 #define FIFOIN_WPOS				mem(&m_core->fifoin.wpos)
@@ -91,6 +130,27 @@ using namespace uml;
 #define FIFOOUT1_NUM			mem(&m_core->fifoout1.num)
 
 
+static inline int flag_shift(uint32_t flag)
+{
+	return 31 - count_leading_zeros(flag);
+}
+
+
+static void count_fifo_usage(const opcode_desc *desc, int *fifoin, int *fifoout0, int *fifoout1)
+{
+	// counts the FIFO accesses of an instruction and its delay slot
+	if (desc->userflags & OP_USERFLAG_FIFOIN)
+		(*fifoin)++;
+	if (desc->userflags & OP_USERFLAG_FIFOOUT0)
+		(*fifoout0)++;
+	if (desc->userflags & OP_USERFLAG_FIFOOUT1)
+		(*fifoout1)++;
+
+	if (desc->delayslots > 0 && desc->delay.first() != nullptr)
+		count_fifo_usage(desc->delay.first(), fifoin, fifoout0, fifoout1);
+}
+
+
 inline void mb86235_device::alloc_handle(drcuml_state *drcuml, code_handle **handleptr, const char *name)
 {
 	if (*handleptr == nullptr)
@@ -147,6 +207,18 @@ static void cfunc_fifoin_trace(void *param)
 	cpu->fifoin_trace();
 }
 
+static void cfunc_external_burst_read(void *param)
+{
+	mb86235_device *cpu = (mb86235_device *)param;
+	cpu->external_burst_read();
+}
+
+static void cfunc_external_burst_write(void *param)
+{
+	mb86235_device *cpu = (mb86235_device *)param;
+	cpu->external_burst_write();
+}
+
 
 
 void mb86235_device::unimplemented_op()
@@ -198,10 +270,122 @@ void mb86235_device::pcs_underflow()
 
 void mb86235_device::fifoin_trace()
 {
-	printf("FIFOIN trace rpos %04X\n", m_core->fifoin.rpos);
+	logerror("FIFOIN pop (rpos %04X)\n", m_core->arg0);
+}
+
+// arg0 = first word address, arg1 = word count, arg2 = address step;
+// a run that stays inside one block of plain RAM is copied through its host pointer,
+// anything else goes through the address space one word at a time, in order
+void mb86235_device::external_burst_read()
+{
+	uint32_t addr = m_core->arg0;
+	int32_t step = m_core->arg2;
+	uint32_t lo = std::min<uint32_t>(addr, addr + (m_core->arg1 - 1) * step);
+	uint32_t hi = std::max<uint32_t>(addr, addr + (m_core->arg1 - 1) * step);
+
+	uint32_t *base = (uint32_t *)m_dataa->get_read_ptr(lo << 2);
+	if (base != nullptr && (uint32_t *)m_dataa->get_read_ptr(hi << 2) == base + (hi - lo))
+	{
+		for (uint32_t i = 0; i < m_core->arg1; i++, addr += step)
+			m_core->burst[i] = base[addr - lo];
+	}
+	else
+	{
+		for (uint32_t i = 0; i < m_core->arg1; i++, addr += step)
+			m_core->burst[i] = m_dataa->read_dword(addr << 2);
+	}
+}
+
+void mb86235_device::external_burst_write()
+{
+	uint32_t addr = m_core->arg0;
+	int32_t step = m_core->arg2;
+	uint32_t lo = std::min<uint32_t>(addr, addr + (m_core->arg1 - 1) * step);
+	uint32_t hi = std::max<uint32_t>(addr, addr + (m_core->arg1 - 1) * step);
+
+	uint32_t *base = (uint32_t *)m_dataa->get_write_ptr(lo << 2);
+	if (base != nullptr && (uint32_t *)m_dataa->get_write_ptr(hi << 2) == base + (hi - lo))
+	{
+		for (uint32_t i = 0; i < m_core->arg1; i++, addr += step)
+			base[addr - lo] = m_core->burst[i];
+	}
+	else
+	{
+		for (uint32_t i = 0; i < m_core->arg1; i++, addr += step)
+			m_dataa->write_dword(addr << 2, m_core->burst[i]);
+	}
+}
+
+void mb86235_device::set_fifo_trace(bool enable)
+{
+	if (enable != m_fifo_trace)
+	{
+		m_fifo_trace = enable;
+
+		// the trace calls are compiled in, so recompile everything before running again
+		m_cache_dirty = true;
+	}
+}
+
+
+
+/*-------------------------------------------------
+assign_fast_iregs - pin the most used AA/AB/MA/MB
+registers to host integer registers
+-------------------------------------------------*/
+
+void mb86235_device::assign_fast_iregs()
+{
+	int regnum;
+
+	// start with everything living in the core state
+	for (regnum = 0; regnum < ARRAY_LENGTH(m_regmap); regnum++)
+		m_regmap[regnum] = get_reg_memory(regnum);
+
+	if (DISABLE_FAST_REGISTERS)
+		return;
+
+	drcbe_info beinfo;
+	m_drcuml->get_backend_info(beinfo);
+
+	// hand out whatever direct registers the backend has left after the scratch registers
+	uint64_t taken = 0;
+	for (int ireg = FIRST_FAST_IREG; ireg < beinfo.direct_iregs && ireg < REG_I_COUNT; ireg++)
+	{
+		int best = -1;
+		for (regnum = 0; regnum < ARRAY_LENGTH(m_regmap); regnum++)
+		{
+			if (!(taken & (uint64_t(1) << regnum)) && (best < 0 || m_reguse[regnum] > m_reguse[best]))
+				best = regnum;
+		}
+
+		taken |= uint64_t(1) << best;
+		m_regmap[best] = parameter::make_ireg(REG_I0 + ireg);
+	}
+
+	// age the usage counts so the choice follows the code that is currently running
+	for (regnum = 0; regnum < ARRAY_LENGTH(m_reguse); regnum++)
+		m_reguse[regnum] >>= 1;
 }
 
 
+/*-------------------------------------------------
+get_reg_memory - return the core state location
+of an AA/AB/MA/MB register or LPC
+-------------------------------------------------*/
+
+uml::parameter mb86235_device::get_reg_memory(int regnum)
+{
+	switch (regnum >> 3)
+	{
+		case 0:		return mem(&m_core->aa[regnum & 7]);
+		case 1:		return mem(&m_core->ab[regnum & 7]);
+		case 2:		return mem(&m_core->ma[regnum & 7]);
+		case 3:		return mem(&m_core->mb[regnum & 7]);
+		default:	return mem(&m_core->lpc);
+	}
+}
+
 
 /*-------------------------------------------------
 load_fast_iregs - load any fast integer
@@ -216,6 +400,7 @@ inline void mb86235_device::load_fast_iregs(drcuml_block *block)
 	{
 		if (m_regmap[regnum].is_int_register())
 		{
+			UML_MOV(block, m_regmap[regnum], get_reg_memory(regnum));
 		}
 	}
 }
@@ -234,6 +419,7 @@ void mb86235_device::save_fast_iregs(drcuml_block *block)
 	{
 		if (m_regmap[regnum].is_int_register())
 		{
+			UML_MOV(block, get_reg_memory(regnum), m_regmap[regnum]);
 		}
 	}
 }
@@ -246,6 +432,28 @@ void mb86235_device::run_drc()
 	drcuml_state *drcuml = m_drcuml.get();
 	int execute_result;
 
+	/* after a reset, keep the compiled code only if it was compiled from the same program, */
+	/* otherwise flush once and prebuild what an earlier run of the new one needed */
+	if (m_reset_check_pending)
+	{
+		uint64_t fingerprint = program_fingerprint();
+		if (m_program_ranges.empty() || !m_reset_fingerprint_valid || fingerprint != m_reset_fingerprint)
+		{
+			load_block_list(fingerprint);
+			m_cache_dirty = false;
+			m_reset_fingerprint = fingerprint;
+			m_reset_fingerprint_valid = true;
+		}
+		m_reset_check_pending = false;
+	}
+
+	/* reset the cache if dirty */
+	if (m_cache_dirty)
+	{
+		flush_cache();
+		m_cache_dirty = false;
+	}
+
 	/* execute */
 	do
 	{
@@ -254,7 +462,8 @@ void mb86235_device::run_drc()
 		/* if we need to recompile, do it */
 		if (execute_result == EXECUTE_MISSING_CODE)
 		{
-			compile_block(m_core->pc);
+			if (!m_drcuml->hash_exists(0, m_core->pc))
+				compile_block(m_core->pc);
 		}
 		else if (execute_result == EXECUTE_UNMAPPED_CODE)
 		{
@@ -264,29 +473,234 @@ void mb86235_device::run_drc()
 		{
 			flush_cache();
 		}
+		else if (execute_result == EXECUTE_INVALIDATED_CODE)
+		{
+			// the entry's hash is taken over by the new block, other stale entries check themselves
+			compile_block(m_core->pc);
+			m_successors.clear();
+		}
+		else if (execute_result == EXECUTE_HOT_BLOCK)
+		{
+			// replace the block with the optimized one, its hash entries are overwritten
+			m_profile[m_core->pc].hot = true;
+			compile_block(m_core->pc);
+			m_successors.clear();
+		}
+
+		/* bring back the hot code if a compile just filled the cache */
+		if (m_refill_pending)
+			refill_cache();
 	} while (execute_result != EXECUTE_OUT_OF_CYCLES);
+
+	/* the timeslice is over, compile where the blocks missed in it are likely to go next */
+	compile_ahead();
+}
+
+
+/*-------------------------------------------------
+refill_cache - compile the most used blocks
+again after the cache filled up and was flushed
+-------------------------------------------------*/
+
+void mb86235_device::refill_cache()
+{
+	// drc_cache can only be reset as a whole, so instead of evicting cold blocks this puts
+	// the hot and most entered ones back straight away, before they miss one by one
+	std::vector<std::pair<uint64_t, offs_t>> ranked;
+	for (auto &entry : m_profile)
+		ranked.push_back(std::make_pair((entry.second.hot ? (uint64_t(1) << 32) : 0) | entry.second.count, entry.first));
+
+	std::sort(ranked.begin(), ranked.end(), std::greater<std::pair<uint64_t, offs_t>>());
+
+	uint32_t flush_count = m_flush_count;
+	int compiled = 0;
+
+	for (auto &entry : ranked)
+	{
+		if (compiled >= CACHE_REFILL_BLOCKS || entry.first == 0)
+			break;
+		if (m_drcuml->hash_exists(0, entry.second))
+			continue;
+
+		compile_block(entry.second);
+		compiled++;
+
+		// the cache can't hold all of them, make sure the current block is there and stop
+		if (m_flush_count != flush_count)
+		{
+			compile_block(m_core->pc);
+			break;
+		}
+	}
+
+	m_refill_pending = false;
+	m_successors.clear();
+
+	logerror("Code cache full, flush %d, %d blocks recompiled\n", m_cache_full_count, compiled);
+}
+
+
+/*-------------------------------------------------
+report_cache_stats - print what the compiler
+did this run and the cache and window sizes
+that would have suited it
+-------------------------------------------------*/
+
+static uint32_t round_up_pow2(uint32_t value)
+{
+	uint32_t result = 1;
+	while (result < value)
+		result <<= 1;
+	return result;
 }
 
-void mb86235_device::compile_block(offs_t pc)
+void mb86235_device::report_cache_stats()
+{
+	if (m_stats.blocks == 0)
+		return;
+
+	double seconds = machine().time().as_double();
+
+	osd_printf_info("%s: %u blocks compiled (%.2f/s), %u bytes and %.1f sequences per block, cache high water %u of %u KB, %u full flushes\n",
+		tag(), (uint32_t)m_stats.blocks, (seconds > 0.0) ? m_stats.blocks / seconds : 0.0,
+		(uint32_t)(m_stats.code_bytes / m_stats.blocks), (double)m_stats.sequences / m_stats.blocks,
+		(uint32_t)(m_stats.high_water / 1024), (uint32_t)(m_cache_size / 1024), m_cache_full_count);
+
+	// a cache that filled up wants to double, otherwise half again what was used, in 64 KB steps
+	size_t cache_size;
+	if (m_cache_full_count > 0)
+		cache_size = m_cache_size * 2;
+	else
+		cache_size = std::max<size_t>(((m_stats.high_water * 3 / 2) + 0xffff) & ~size_t(0xffff), 256 * 1024);
+
+	// a window or sequence limit that was reached may be cutting blocks short
+	uint32_t forwards = (m_stats.max_span >= m_compile_forwards) ? m_compile_forwards * 2 : std::max<uint32_t>(round_up_pow2(m_stats.max_span), 32);
+	uint32_t max_sequence = (m_stats.max_sequence >= m_compile_max_sequence) ? m_compile_max_sequence * 2 : std::max<uint32_t>(round_up_pow2(m_stats.max_sequence), 8);
+
+	osd_printf_info("%s: suggested MCFG_MB86235_CACHE_SIZE(%u) MCFG_MB86235_COMPILE_WINDOW(%u, %u, %u)\n",
+		tag(), (uint32_t)cache_size, m_compile_backwards, forwards, max_sequence);
+}
+
+void mb86235_device::compile_block(offs_t pc, bool speculative)
 {
 	compiler_state compiler = { 0 };
 
 	const opcode_desc *seqhead, *seqlast;
 	const opcode_desc *desclist;
-	bool override = false;
 
-	drcuml_block *block;
+	drcuml_block *block = nullptr;
+
+	// hot blocks stay hot across flushes, and replace all of their old hash entries; the hot
+	// tier does no load elimination, a RAM read from a known address is already a single
+	// direct access (AR tracking), and with every host register but the scratch ones given
+	// to AA/AB/MA/MB there is nowhere to keep a loaded value that is cheaper than the RAM
+	block_profile &profile = m_profile[pc];
+	compiler.hot = profile.hot;
+	bool override = profile.hot;
+	uint32_t reguse_weight = profile.hot ? HOT_BLOCK_REGUSE_WEIGHT : 1;
 
 	desclist = m_drcfe->describe_code(pc);
 
+	// the program pages this block was compiled from
+	uint32_t lastpc = pc;
+	m_block_pages.clear();
+	for (const opcode_desc *curdesc = desclist; curdesc != nullptr; curdesc = curdesc->next())
+	{
+		lastpc = std::max<uint32_t>(lastpc, curdesc->pc + curdesc->delayslots);
+		for (uint32_t page = curdesc->pc >> CODE_PAGE_SHIFT; page <= (curdesc->pc + curdesc->delayslots) >> CODE_PAGE_SHIFT; page++)
+			m_block_pages.push_back(page);
+	}
+
+	// flag liveness reads code past the block, so it is worked out before anything is
+	// generated and the pages it read are checked along with the block's own
+	m_flagreq.clear();
+	if (!DISABLE_FLAG_LIVENESS)
+	{
+		for (const opcode_desc *curdesc = desclist; curdesc != nullptr; curdesc = curdesc->next())
+		{
+			m_flagreq[curdesc] = m_drcfe->flags_required(*curdesc, compiler.hot);
+			for (const opcode_desc *delaydesc = curdesc->delay.first(); delaydesc != nullptr; delaydesc = delaydesc->next())
+				m_flagreq[delaydesc] = m_drcfe->flags_required(*delaydesc, compiler.hot);
+		}
+		m_drcfe->take_scanned_pages(m_block_pages);
+	}
+	std::sort(m_block_pages.begin(), m_block_pages.end());
+	m_block_pages.erase(std::unique(m_block_pages.begin(), m_block_pages.end()), m_block_pages.end());
+
+	// gather register usage for the fast register allocator
+	for (const opcode_desc *curdesc = desclist; curdesc != nullptr; curdesc = curdesc->next())
+	{
+		uint32_t used = curdesc->regin[0] | curdesc->regout[0];
+		for (int regnum = 0; regnum < 32; regnum++)
+			if (used & (1 << regnum))
+				m_reguse[regnum] += reguse_weight;
+
+		// the loop counter is live across the whole body of a hardware loop
+		if (curdesc->userflags & OP_USERFLAG_LPC)
+		{
+			if (curdesc->targetpc != BRANCH_TARGET_DYNAMIC && curdesc->targetpc <= curdesc->pc)
+				m_reguse[REGMAP_LPC] += (curdesc->pc - curdesc->targetpc + 1) * reguse_weight;
+			else
+				m_reguse[REGMAP_LPC] += reguse_weight;
+		}
+	}
+
+	// UML budget: each sequence generates its instructions twice when the FIFO guard applies,
+	// every exit and debugger hook spills the fast registers, and each code check (at the
+	// head and at FIFO resume points) compares every page the block depends on
+	uint32_t spills = (REG_I_COUNT - FIRST_FAST_IREG) * (((machine().debug_flags & DEBUG_FLAG_ENABLED) != 0) ? 3 : 1);
+	uint32_t umlbudget = UML_PER_BLOCK;
+	for (seqhead = desclist; seqhead != nullptr; seqhead = seqlast->next())
+	{
+		uint32_t seqinst = 0, checks = 1;
+		int fifoin = 0, fifoout0 = 0, fifoout1 = 0;
+		for (seqlast = seqhead; seqlast != nullptr; seqlast = seqlast->next())
+		{
+			seqinst += 1 + seqlast->delayslots;
+			if (seqlast->userflags & (OP_USERFLAG_FIFOIN | OP_USERFLAG_FIFOOUT0 | OP_USERFLAG_FIFOOUT1))
+				checks++;
+			count_fifo_usage(seqlast, &fifoin, &fifoout0, &fifoout1);
+			if (seqlast->flags & OPFLAG_END_SEQUENCE)
+				break;
+		}
+		assert(seqlast != nullptr);
+
+		uint32_t copies = (fifoin + fifoout0 + fifoout1 > 1) ? 2 : 1;
+		umlbudget += UML_PER_SEQUENCE + checks * 2 * m_block_pages.size() + copies * seqinst * (UML_PER_INSTRUCTION + spills);
+	}
+
+	// a block that doesn't fit is compiled in parts, the sequences past the split
+	// are left to nocode, which compiles them as blocks of their own
+	uint32_t seqlimit = ~0;
+	bool flushed = false;
+
 	bool succeeded = false;
 	while (!succeeded)
 	{
+		drccodeptr codestart = m_cache->top();
+		uint32_t sequences = 0;
+
+		/* find the first sequence left out of this attempt */
+		compiler.splitpc = ~0;
+		uint32_t seqcount = 0;
+		for (seqhead = desclist; seqhead != nullptr; seqhead = seqlast->next())
+		{
+			if (seqcount++ == seqlimit)
+			{
+				compiler.splitpc = seqhead->pc;
+				break;
+			}
+			for (seqlast = seqhead; seqlast != nullptr; seqlast = seqlast->next())
+				if (seqlast->flags & OPFLAG_END_SEQUENCE)
+					break;
+			assert(seqlast != nullptr);
+		}
+
 		try
 		{
-			block = m_drcuml->begin_block(4096);
+			block = m_drcuml->begin_block(umlbudget);
 
-			for (seqhead = desclist; seqhead != nullptr; seqhead = seqlast->next())
+			for (seqhead = desclist; seqhead != nullptr && seqhead->pc < compiler.splitpc; seqhead = seqlast->next())
 			{
 				const opcode_desc *curdesc;
 				uint32_t nextpc;
@@ -297,6 +711,9 @@ void mb86235_device::compile_block(offs_t pc)
 						break;
 				assert(seqlast != nullptr);
 
+				sequences++;
+				m_stats.max_sequence = std::max<uint32_t>(m_stats.max_sequence, seqlast->pc - seqhead->pc + 1);
+
 				/* if we don't have a hash for this mode/pc, or if we are overriding all, add one */
 				if (override || m_drcuml->hash_exists(0, seqhead->pc))
 					UML_HASH(block, 0, seqhead->pc);                                        // hash    mode,pc
@@ -317,13 +734,78 @@ void mb86235_device::compile_block(offs_t pc)
 					continue;
 				}
 
+				/* entering from outside, make sure the program hasn't been rewritten */
+				generate_code_check(block, &compiler, seqhead->pc);
+
 				/* label this instruction, if it may be jumped to locally */
 				if (seqhead->flags & OPFLAG_IS_BRANCH_TARGET)
 					UML_LABEL(block, seqhead->pc | 0x80000000);                             // label   seqhead->pc
 
-																							/* iterate over instructions in the sequence and compile them */
+				/* count entries to the block until it is hot enough to recompile */
+				if (HOT_BLOCK_THRESHOLD > 0 && seqhead == desclist && !compiler.hot)
+				{
+					code_label cold = compiler.labelnum++;
+					UML_ADD(block, mem(&profile.count), mem(&profile.count), 1);          // add     [count],[count],1
+					UML_CMP(block, mem(&profile.count), HOT_BLOCK_THRESHOLD);             // cmp     [count],HOT_BLOCK_THRESHOLD
+					UML_JMPc(block, COND_B, cold);                                        // jmp     cold,B
+					UML_MOV(block, mem(&m_core->pc), pc);                                 // mov     [pc],pc
+					save_fast_iregs(block);                                               // <save fastregs>
+					UML_EXIT(block, EXECUTE_HOT_BLOCK);                                   // exit    EXECUTE_HOT_BLOCK
+					UML_LABEL(block, cold);                                               // cold:
+				}
+
+				/* sequences can be entered from anywhere, so the PR pointers and flag kinds are unknown here */
+				compiler.prp = -1;
+				compiler.pwp = -1;
+				compiler.alukind = -1;
+				compiler.mulkind = -1;
+				compiler.arknown = 0;
+
+				/* count the FIFO accesses of the whole sequence, a repeated one can't be counted up front */
+				/* and a FIFO clear in the middle invalidates the count */
+				int fifoin = 0, fifoout0 = 0, fifoout1 = 0;
+				bool fifouncounted = false;
 				for (curdesc = seqhead; curdesc != seqlast->next(); curdesc = curdesc->next())
-					generate_sequence_instruction(block, &compiler, curdesc);
+				{
+					count_fifo_usage(curdesc, &fifoin, &fifoout0, &fifoout1);
+					if ((curdesc->userflags & OP_USERFLAG_REPEATED_OP) &&
+						(curdesc->userflags & (OP_USERFLAG_FIFOIN | OP_USERFLAG_FIFOOUT0 | OP_USERFLAG_FIFOOUT1)))
+						fifouncounted = true;
+					if ((curdesc->userflags & OP_USERFLAG_FIFO_CLEAR) ||
+						(curdesc->delay.first() != nullptr && (curdesc->delay.first()->userflags & OP_USERFLAG_FIFO_CLEAR)))
+						fifouncounted = true;
+				}
+
+				/* if there is more than one, check for all of them once and run a copy without */
+				/* per-instruction checks, falling back to the checked copy if the FIFOs can't cover it */
+				if (!DISABLE_FIFO_GUARD && !fifouncounted && fifoin + fifoout0 + fifoout1 > 1 &&
+					fifoin <= FIFOIN_SIZE && fifoout0 < FIFOOUT0_SIZE && fifoout1 < FIFOOUT1_SIZE)
+				{
+					code_label slow = compiler.labelnum++;
+					code_label done = compiler.labelnum++;
+					compiler_state compiler_slow = compiler;
+
+					generate_fifo_guard(block, fifoin, fifoout0, fifoout1, slow);
+
+					compiler.fifo_guarded = 1;
+					for (curdesc = seqhead; curdesc != seqlast->next(); curdesc = curdesc->next())
+						generate_sequence_instruction(block, &compiler, curdesc);
+					UML_JMP(block, done);
+
+					compiler_slow.labelnum = compiler.labelnum;
+					compiler = compiler_slow;
+
+					UML_LABEL(block, slow);
+					for (curdesc = seqhead; curdesc != seqlast->next(); curdesc = curdesc->next())
+						generate_sequence_instruction(block, &compiler, curdesc);
+					UML_LABEL(block, done);
+				}
+				else
+				{
+					/* iterate over instructions in the sequence and compile them */
+					for (curdesc = seqhead; curdesc != seqlast->next(); curdesc = curdesc->next())
+						generate_sequence_instruction(block, &compiler, curdesc);
+				}
 
 				/* if we need to return to the start, do it */
 				if (seqlast->flags & OPFLAG_RETURN_TO_START)
@@ -335,17 +817,239 @@ void mb86235_device::compile_block(offs_t pc)
 				/* count off cycles and go there */
 				generate_update_cycles(block, &compiler, nextpc, true);                     // <subtract cycles>
 
-				if (seqlast->next() == nullptr || seqlast->next()->pc != nextpc)
-					UML_HASHJMP(block, 0, nextpc, *m_nocode);                               // hashjmp <mode>,nextpc,nocode
+				if (seqlast->next() == nullptr || seqlast->next()->pc != nextpc || nextpc >= compiler.splitpc)
+					generate_static_jump(block, &compiler, desclist, nextpc);               // <jmp or hashjmp>
+			}
+
+			block->end();
+			succeeded = true;
+
+			m_stats.blocks++;
+			m_stats.sequences += sequences;
+			m_stats.code_bytes += m_cache->top() - codestart;
+			m_stats.max_span = std::max<uint32_t>(m_stats.max_span, lastpc - pc + 1);
+			m_stats.high_water = std::max<size_t>(m_stats.high_water, m_cache->top() - m_cache->base());
+		}
+		catch (drcuml_block::abort_compilation &)
+		{
+			// try the first half of what didn't fit before giving up the rest of the cache
+			if (sequences > 1)
+			{
+				seqlimit = sequences / 2;
+			}
+			else if (!flushed)
+			{
+				flush_cache();
+				flushed = true;
+				seqlimit = ~0;
+				m_cache_full_count++;
+				m_refill_pending = true;
+			}
+			else
+			{
+				fatalerror("mb86235: sequence at %08X does not fit in an empty code cache\n", pc);
+			}
+		}
+		catch (emu_fatalerror &)
+		{
+			// code that can't be compiled is only an error once it is reached, so a
+			// speculative compile just drops the block
+			if (!speculative)
+				throw;
+			try
+			{
+				block->abort();
+			}
+			catch (drcuml_block::abort_compilation &)
+			{
+			}
+			return;
+		}
+	}
+
+	if (m_cache_dir != nullptr && m_block_pcs.size() < BLOCK_LIST_MAX &&
+		std::find(m_block_pcs.begin(), m_block_pcs.end(), pc) == m_block_pcs.end())
+		m_block_pcs.push_back(pc);
+
+	/* remember where this block can leave to */
+	for (const opcode_desc *curdesc = desclist; curdesc != nullptr && m_successors.size() < COMPILE_AHEAD_SUCCESSORS; curdesc = curdesc->next())
+	{
+		if (curdesc->targetpc != BRANCH_TARGET_DYNAMIC && !(curdesc->flags & OPFLAG_INTRABLOCK_BRANCH))
+			m_successors.push_back(curdesc->targetpc);
+
+		uint32_t nextpc = curdesc->pc + curdesc->skipslots + 1;
+		if ((curdesc->flags & OPFLAG_END_SEQUENCE) && !(curdesc->flags & OPFLAG_IS_UNCONDITIONAL_BRANCH) &&
+			(curdesc->next() == nullptr || curdesc->next()->pc != nextpc))
+			m_successors.push_back(nextpc);
+	}
+}
+
+
+/*-------------------------------------------------
+compile_ahead - compile the blocks that the ones
+compiled in the last timeslice may continue into
+-------------------------------------------------*/
+
+void mb86235_device::compile_ahead()
+{
+	// The drcuml state and code cache can't be used from another thread, so instead of
+	// compiling on a worker this runs at the end of a timeslice, off the miss path, and
+	// compiles the successors of the blocks that missed in it. Nothing is compiled ahead
+	// once the cache is mostly full, so speculation never causes a flush.
+	uint32_t flush_count = m_flush_count;
+	int compiled = 0;
+
+	while (!m_successors.empty() && compiled < COMPILE_AHEAD_BLOCKS &&
+		size_t(m_cache->top() - m_cache->base()) < m_cache_size - m_cache_size / COMPILE_AHEAD_CACHE_RESERVE)
+	{
+		offs_t pc = m_successors.front();
+		m_successors.erase(m_successors.begin());
+
+		if (m_drcuml->hash_exists(0, pc))
+			continue;
+
+		compile_block(pc, true);
+		compiled++;
+
+		// a full cache threw away the block execution resumes in, get it back and stop
+		if (m_flush_count != flush_count)
+		{
+			compile_block(m_core->pc);
+			break;
+		}
+	}
+
+	m_successors.clear();
+}
+
+
+
+/*-------------------------------------------------
+program_fingerprint - hash every mapped word of
+the program space, to key the block list file
+-------------------------------------------------*/
+
+uint64_t mb86235_device::program_fingerprint()
+{
+	// 64-bit FNV-1a over every program word, with the range bounds so a remap changes the hash too
+	uint64_t hash = 0xcbf29ce484222325U;
+	for (auto &range : m_program_ranges)
+	{
+		hash ^= (uint64_t(range.first) << 32) | range.second;
+		hash *= 0x100000001b3U;
+		for (offs_t pc = range.first; ; pc++)
+		{
+			uint64_t op = m_direct->read_qword(pc * 8, 0);
+			for (int i = 0; i < 8; i++)
+			{
+				hash ^= (op >> (i * 8)) & 0xff;
+				hash *= 0x100000001b3U;
 			}
+			if (pc == range.second)
+				break;
+		}
+	}
+	return hash;
+}
+
+
+/*-------------------------------------------------
+program_mapped - true if the pc is in a range
+covered by the program fingerprint
+-------------------------------------------------*/
+
+bool mb86235_device::program_mapped(offs_t pc)
+{
+	for (auto &range : m_program_ranges)
+		if (pc >= range.first && pc <= range.second)
+			return true;
+	return false;
+}
+
+
+/*-------------------------------------------------
+load_block_list - start over for a new program,
+compiling the blocks an earlier run of it recorded
+-------------------------------------------------*/
+
+void mb86235_device::load_block_list(uint64_t hash)
+{
+	// blocks recorded for another program don't belong in this one's list
+	if (hash != m_block_pcs_fingerprint)
+	{
+		m_block_pcs.clear();
+		m_block_pcs_fingerprint = hash;
+	}
+
+	// the one flush waits for the register assignment the last run settled on
+	std::vector<uint32_t> pcs;
+	if (m_cache_dir != nullptr)
+		read_block_list(hash, pcs);
+	flush_cache();
+
+	for (uint32_t pc : pcs)
+	{
+		if (program_mapped(pc) && !m_drcuml->hash_exists(0, pc))
+			compile_block(pc, true);
+	}
+}
+
+
+/*-------------------------------------------------
+read_block_list - read the block list file of a
+program, taking over its register usage counts
+-------------------------------------------------*/
+
+bool mb86235_device::read_block_list(uint64_t hash, std::vector<uint32_t> &pcs)
+{
+	emu_file file(m_cache_dir, OPEN_FLAG_READ);
+	if (file.open(string_format("mb86235_%016llx.blk", (unsigned long long)hash).c_str()) != osd_file::error::NONE)
+		return false;
+
+	uint32_t header[3];
+	uint64_t filehash;
+	if (file.read(header, sizeof(header)) != sizeof(header) || file.read(&filehash, sizeof(filehash)) != sizeof(filehash))
+		return false;
+	if (header[0] != BLOCK_LIST_MAGIC || header[1] != BLOCK_LIST_VERSION || header[2] > BLOCK_LIST_MAX || filehash != hash)
+		return false;
+
+	uint32_t reguse[ARRAY_LENGTH(m_reguse)];
+	std::vector<uint32_t> filepcs(header[2]);
+	if (file.read(reguse, sizeof(reguse)) != sizeof(reguse))
+		return false;
+	if (header[2] > 0 && file.read(&filepcs[0], header[2] * sizeof(uint32_t)) != header[2] * sizeof(uint32_t))
+		return false;
+
+	memcpy(m_reguse, reguse, sizeof(m_reguse));
+	pcs = std::move(filepcs);
+	return true;
+}
+
+
+/*-------------------------------------------------
+save_block_list - record the blocks compiled in
+this run for the next one
+-------------------------------------------------*/
 
-			block->end();
-			succeeded = true;
-		}
-		catch (drcuml_block::abort_compilation &)
-		{
-			flush_cache();
-		}
+void mb86235_device::save_block_list()
+{
+	// file the list under the program it was recorded from, even if that has changed since
+	uint64_t hash = m_block_pcs_fingerprint;
+	if (m_block_pcs.empty())
+		return;
+
+	emu_file file(m_cache_dir, OPEN_FLAG_WRITE | OPEN_FLAG_CREATE | OPEN_FLAG_CREATE_PATHS);
+	if (file.open(string_format("mb86235_%016llx.blk", (unsigned long long)hash).c_str()) != osd_file::error::NONE)
+		return;
+
+	uint32_t header[3] = { BLOCK_LIST_MAGIC, BLOCK_LIST_VERSION, uint32_t(m_block_pcs.size()) };
+	file.write(header, sizeof(header));
+	file.write(&hash, sizeof(hash));
+	file.write(m_reguse, sizeof(m_reguse));
+	for (offs_t pc : m_block_pcs)
+	{
+		uint32_t value = pc;
+		file.write(&value, sizeof(value));
 	}
 }
 
@@ -410,6 +1114,24 @@ void mb86235_device::static_generate_out_of_cycles()
 	block->end();
 }
 
+void mb86235_device::static_generate_invalidated_code()
+{
+	drcuml_block *block;
+
+	/* begin generating */
+	block = m_drcuml->begin_block(10);
+
+	/* exit to recompile the block at the exception parameter */
+	alloc_handle(m_drcuml.get(), &m_invalidated_code, "invalidated_code");
+	UML_HANDLE(block, *m_invalidated_code);                                                 // handle  invalidated_code
+	UML_GETEXP(block, I0);                                                                  // getexp  i0
+	UML_MOV(block, mem(&m_core->pc), I0);                                                   // mov     <pc>,i0
+	save_fast_iregs(block);                                                                 // <save fastregs>
+	UML_EXIT(block, EXECUTE_INVALIDATED_CODE);                                              // exit    EXECUTE_INVALIDATED_CODE
+
+	block->end();
+}
+
 void mb86235_device::static_generate_fifo()
 {
 	drcuml_block *block;
@@ -449,55 +1171,99 @@ void mb86235_device::static_generate_fifo()
 	UML_RET(block);
 
 	block->end();
+}
+
+
+void mb86235_device::static_generate_memory_accessors()
+{
+	// I0 = word address, I1 = data
+	// the internal RAM of each bus is accessed straight through its host pointer,
+	// anything outside it goes through the address space
+	for (int bank = 0; bank < 2; bank++)
+	{
+		uint32_t *ram = m_internal_ram[bank];
+		uml::memory_space space = bank ? SPACE_IO : SPACE_DATA;
+		code_label outside = 1;
+		drcuml_block *block;
+
+		// read
+		block = m_drcuml->begin_block(20);
+
+		alloc_handle(m_drcuml.get(), &m_read_ram[bank], bank ? "read_ram_b" : "read_ram_a");
+		UML_HANDLE(block, *m_read_ram[bank]);                                                   // handle  read_ram_x
+		if (ram != nullptr)
+		{
+			UML_CMP(block, I0, INTERNAL_RAM_WORDS);                                             // cmp     i0,INTERNAL_RAM_WORDS
+			UML_JMPc(block, COND_AE, outside);                                                  // jmp     outside,AE
+			UML_LOAD(block, I1, ram, I0, SIZE_DWORD, SCALE_x4);                                 // load    i1,ram,i0,dword_x4
+			UML_RET(block);                                                                     // ret
+			UML_LABEL(block, outside);                                                          // outside:
+		}
+		UML_SHL(block, I0, I0, 2);                                                              // shl     i0,i0,2
+		UML_READ(block, I1, I0, SIZE_DWORD, space);                                             // read    i1,i0,dword,space
+		UML_RET(block);                                                                         // ret
+
+		block->end();
 
-	// read fifo in
-	// I0 = return value
-	block = m_drcuml->begin_block(32);
-	alloc_handle(m_drcuml.get(), &m_read_fifo_in, "read_fifo_in");
-	UML_HANDLE(block, *m_read_fifo_in);
+		// write
+		block = m_drcuml->begin_block(20);
 
-	UML_MOV(block, mem(&m_core->arg0), FIFOIN_RPOS);
-	UML_CALLC(block, cfunc_fifoin_trace, this);
+		alloc_handle(m_drcuml.get(), &m_write_ram[bank], bank ? "write_ram_b" : "write_ram_a");
+		UML_HANDLE(block, *m_write_ram[bank]);                                                  // handle  write_ram_x
+		if (ram != nullptr)
+		{
+			UML_CMP(block, I0, INTERNAL_RAM_WORDS);                                             // cmp     i0,INTERNAL_RAM_WORDS
+			UML_JMPc(block, COND_AE, outside);                                                  // jmp     outside,AE
+			UML_STORE(block, ram, I0, I1, SIZE_DWORD, SCALE_x4);                                // store   ram,i0,i1,dword_x4
+			UML_RET(block);                                                                     // ret
+			UML_LABEL(block, outside);                                                          // outside:
+		}
+		UML_SHL(block, I0, I0, 2);                                                              // shl     i0,i0,2
+		UML_WRITE(block, I0, I1, SIZE_DWORD, space);                                            // write   i0,i1,dword,space
+		UML_RET(block);                                                                         // ret
+
+		block->end();
+	}
+}
+
+void mb86235_device::generate_read_fifo_in(drcuml_block *block, uml::parameter dst)
+{
+	// pops FIFO IN into dst, clobbers I0 and I1
+	if (m_fifo_trace)
+	{
+		UML_MOV(block, mem(&m_core->arg0), FIFOIN_RPOS);
+		UML_CALLC(block, cfunc_fifoin_trace, this);
+	}
 
 	UML_MOV(block, I1, FIFOIN_RPOS);
 	UML_LOAD(block, I0, m_core->fifoin.data, I1, SIZE_QWORD, SCALE_x8);
 	UML_ADD(block, I1, I1, 1);
-	UML_AND(block, I1, I1, FIFOIN_SIZE-1);
-	UML_MOV(block, FIFOIN_RPOS, I1);
+	UML_AND(block, FIFOIN_RPOS, I1, FIFOIN_SIZE - 1);
 	UML_SUB(block, FIFOIN_NUM, FIFOIN_NUM, 1);
-	UML_RET(block);
-
-	block->end();
+	UML_MOV(block, dst, I0);
+}
 
-	// write fifo out0
-	// I0 = input value
-	block = m_drcuml->begin_block(32);
-	alloc_handle(m_drcuml.get(), &m_write_fifo_out0, "write_fifo_out0");
-	UML_HANDLE(block, *m_write_fifo_out0);
+void mb86235_device::generate_write_fifo_out0(drcuml_block *block, uml::parameter src)
+{
+	// pushes src to FIFO OUT0, clobbers I0 and I1
+	UML_MOV(block, I0, src);
 	UML_MOV(block, I1, FIFOOUT0_WPOS);
 	UML_STORE(block, m_core->fifoout0.data, I1, I0, SIZE_QWORD, SCALE_x8);
 	UML_ADD(block, I1, I1, 1);
-	UML_AND(block, I1, I1, FIFOOUT0_SIZE - 1);
-	UML_MOV(block, FIFOOUT0_WPOS, I1);
+	UML_AND(block, FIFOOUT0_WPOS, I1, FIFOOUT0_SIZE - 1);
 	UML_ADD(block, FIFOOUT0_NUM, FIFOOUT0_NUM, 1);
-	UML_RET(block);
-
-	block->end();
-
-	// write fifo out1
-	block = m_drcuml->begin_block(32);
-	alloc_handle(m_drcuml.get(), &m_write_fifo_out1, "write_fifo_out1");
-	UML_HANDLE(block, *m_write_fifo_out1);
-	// TODO
-	UML_RET(block);
-
-	block->end();
 }
 
 void mb86235_device::flush_cache()
 {
+	m_drcfe->flush_flag_liveness();
+
+	/* the whole cache is regenerated, so this is the only safe point to move registers around */
+	assign_fast_iregs();
+
 	/* empty the transient cache contents */
 	m_drcuml->reset();
+	m_flush_count++;
 
 	try
 	{
@@ -505,9 +1271,11 @@ void mb86235_device::flush_cache()
 		static_generate_entry_point();
 		static_generate_nocode_handler();
 		static_generate_out_of_cycles();
+		static_generate_invalidated_code();
 
 		// generate utility functions
 		static_generate_fifo();
+		static_generate_memory_accessors();
 
 		// generate exception handlers
 	}
@@ -531,6 +1299,10 @@ void mb86235_device::generate_sequence_instruction(drcuml_block *block, compiler
 																							/* accumulate total cycles */
 	compiler->cycles += desc->cycles;
 
+	/* only compute the flags that can be read later */
+	auto flagreq = m_flagreq.find(desc);
+	compiler->flagreq = (flagreq != m_flagreq.end()) ? flagreq->second : 0x3fff;
+
 	/* update the icount map variable */
 	UML_MAPVAR(block, MAPVAR_CYCLES, compiler->cycles);                                     // mapvar  CYCLES,compiler->cycles
 
@@ -540,6 +1312,7 @@ void mb86235_device::generate_sequence_instruction(drcuml_block *block, compiler
 		UML_MOV(block, mem(&m_core->pc), desc->pc);                                         // mov     [pc],desc->pc
 		save_fast_iregs(block);                                                             // <save fastregs>
 		UML_DEBUG(block, desc->pc);                                                         // debug   desc->pc
+		load_fast_iregs(block);                                                             // <load fastregs>
 	}
 
 	/* if we hit an unmapped address, fatal error */
@@ -562,11 +1335,210 @@ void mb86235_device::generate_sequence_instruction(drcuml_block *block, compiler
 		{
 			UML_MOV(block, mem(&m_core->pc), desc->pc);                                     // mov     [pc],desc->pc
 			UML_DMOV(block, mem(&m_core->arg64), desc->opptr.q[0]);                         // dmov    [arg64],*desc->opptr.q
+			save_fast_iregs(block);                                                         // <save fastregs>
 			UML_CALLC(block, cfunc_unimplemented, this);                                    // callc   cfunc_unimplemented,ppc
 		}
 	}
 }
 
+void mb86235_device::generate_pr_read(drcuml_block *block, compiler_state *compiler, uml::parameter dst)
+{
+	if (!DISABLE_PR_TRACKING && compiler->prp >= 0)
+		UML_MOV(block, dst, mem(&m_core->pr[compiler->prp]));
+	else
+		UML_LOAD(block, dst, m_core->pr, PRP, SIZE_DWORD, SCALE_x4);
+}
+
+void mb86235_device::generate_pr_write(drcuml_block *block, compiler_state *compiler, uml::parameter src)
+{
+	if (!DISABLE_PR_TRACKING && compiler->pwp >= 0)
+		UML_MOV(block, mem(&m_core->pr[compiler->pwp]), src);
+	else
+		UML_STORE(block, m_core->pr, PWP, src, SIZE_DWORD, SCALE_x4);
+}
+
+void mb86235_device::generate_pr_update(drcuml_block *block, compiler_state *compiler, bool pw, int mode)
+{
+	// Steps PRP or PWP around the 24-entry ring. Once the pointer is known (after PR#0/PW#0 or
+	// an immediate write), the new value is stored as a constant and PR accesses use a fixed
+	// address. The pointer in memory is always kept up to date, so any exit sees the right value.
+	int32_t &known = pw ? compiler->pwp : compiler->prp;
+	uml::parameter ptr = pw ? PWP : PRP;
+
+	if (mode == 3)			// #0
+	{
+		UML_MOV(block, ptr, 0);
+		known = 0;
+		return;
+	}
+
+	if (!DISABLE_PR_TRACKING && known >= 0)
+	{
+		known = (mode == 1) ? ((known == 23) ? 0 : known + 1) : ((known == 0) ? 23 : known - 1);
+		UML_MOV(block, ptr, known);
+		return;
+	}
+
+	switch (mode)
+	{
+		case 1:		// ++
+			UML_ADD(block, ptr, ptr, 1);
+			UML_CMP(block, ptr, 24);
+			UML_MOVc(block, COND_GE, ptr, 0);
+			break;
+		case 2:		// --
+			UML_SUB(block, ptr, ptr, 1);
+			UML_CMP(block, ptr, 0);
+			UML_MOVc(block, COND_L, ptr, 23);
+			break;
+	}
+}
+
+void mb86235_device::generate_repeat_start(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, code_label loop)
+{
+	// A repeated op runs as a native loop. The iterations that fit in the remaining cycles and
+	// FIFO contents are counted and charged up front; if RPC isn't exhausted after that, the
+	// loop exits through out_of_cycles and resumes here on the next timeslice.
+	code_label go = compiler->labelnum++;
+
+	// the whole run is charged here instead of by the sequence
+	compiler->cycles -= desc->cycles;
+	UML_MAPVAR(block, MAPVAR_CYCLES, compiler->cycles);
+
+	// at least one iteration, even if RPC is zero or negative; RPC is clamped before it is
+	// compared with icount, so a count with bit 31 set doesn't reach the slice length
+	UML_MOV(block, I0, RPC);
+	UML_CMP(block, I0, 1);
+	UML_MOVc(block, COND_L, I0, 1);
+	UML_CMP(block, I0, mem(&m_core->icount));
+	UML_MOVc(block, COND_G, I0, mem(&m_core->icount));
+	UML_CMP(block, I0, 1);
+	UML_MOVc(block, COND_L, I0, 1);
+
+	int fifoin = 0, fifoout0 = 0, fifoout1 = 0;
+	count_fifo_usage(desc, &fifoin, &fifoout0, &fifoout1);
+	if (fifoin > 0)
+	{
+		UML_CMP(block, I0, FIFOIN_NUM);
+		UML_MOVc(block, COND_G, I0, FIFOIN_NUM);
+	}
+	if (fifoout0 > 0)
+	{
+		UML_MOV(block, I1, FIFOOUT0_SIZE - 1);
+		UML_SUB(block, I1, I1, FIFOOUT0_NUM);
+		UML_CMP(block, I0, I1);
+		UML_MOVc(block, COND_G, I0, I1);
+	}
+	if (fifoout1 > 0)
+	{
+		UML_MOV(block, I1, FIFOOUT1_SIZE - 1);
+		UML_SUB(block, I1, I1, FIFOOUT1_NUM);
+		UML_CMP(block, I0, I1);
+		UML_MOVc(block, COND_G, I0, I1);
+	}
+
+	// FIFO stall before the first iteration
+	UML_CMP(block, I0, 0);
+	UML_JMPc(block, COND_G, go);
+	UML_MOV(block, mem(&m_core->icount), 0);
+	UML_EXH(block, *m_out_of_cycles, desc->pc);
+
+	UML_LABEL(block, go);
+	UML_MOV(block, mem(&m_core->repcount), I0);
+	if (desc->cycles != 1)
+		UML_MULU(block, I0, I0, I0, desc->cycles);
+	UML_SUB(block, mem(&m_core->icount), mem(&m_core->icount), I0);
+
+	UML_LABEL(block, loop);
+
+	// the PR pointers, the lazy flag kinds and the address registers change on every iteration
+	compiler->prp = -1;
+	compiler->pwp = -1;
+	compiler->alukind = -1;
+	compiler->mulkind = -1;
+	compiler->arknown = 0;
+}
+
+void mb86235_device::generate_repeat_end(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, code_label loop)
+{
+	code_label done = compiler->labelnum++;
+
+	UML_SUB(block, RPC, RPC, 1);
+	UML_SUB(block, mem(&m_core->repcount), mem(&m_core->repcount), 1);
+	UML_CMP(block, mem(&m_core->repcount), 0);
+	UML_JMPc(block, COND_G, loop);
+
+	UML_CMP(block, RPC, 0);
+	UML_JMPc(block, COND_LE, done);
+
+	// out of cycles or FIFO space with iterations left, end the timeslice and come back
+	UML_CMP(block, mem(&m_core->icount), 0);
+	UML_MOVc(block, COND_G, mem(&m_core->icount), 0);
+	UML_EXH(block, *m_out_of_cycles, desc->pc);
+
+	UML_LABEL(block, done);
+}
+
+void mb86235_device::generate_fifo_guard(drcuml_block *block, int fifoin, int fifoout0, int fifoout1, code_label fail)
+{
+	// Jumps to fail unless FIFO IN holds fifoin entries and the output FIFOs have room
+	// for the given number of writes
+	if (fifoin > 0)
+	{
+		UML_CMP(block, FIFOIN_NUM, fifoin);
+		UML_JMPc(block, COND_L, fail);
+	}
+	if (fifoout0 > 0)
+	{
+		UML_CMP(block, FIFOOUT0_NUM, FIFOOUT0_SIZE - fifoout0);
+		UML_JMPc(block, COND_GE, fail);
+	}
+	if (fifoout1 > 0)
+	{
+		UML_CMP(block, FIFOOUT1_NUM, FIFOOUT1_SIZE - fifoout1);
+		UML_JMPc(block, COND_GE, fail);
+	}
+}
+
+void mb86235_device::generate_code_check(drcuml_block *block, compiler_state *compiler, offs_t pc)
+{
+	// Leaves through invalidated_code if any page the block was compiled from has been
+	// rewritten since. Only entries from outside the block are checked, a running block
+	// can't see a rewrite because the host only writes between timeslices.
+	if (DISABLE_CODE_INVALIDATION)
+		return;
+
+	for (uint32_t page : m_block_pages)
+	{
+		uint32_t &generation = m_code_generation[page];
+		UML_CMP(block, mem(&generation), generation);                                     // cmp     [generation],generation
+		UML_EXHc(block, COND_NE, *m_invalidated_code, pc);                                // exh     invalidated_code,pc,NE
+	}
+}
+
+void mb86235_device::invalidate_code(offs_t start, offs_t end)
+{
+	// Called when the program space between start and end (instruction addresses, inclusive)
+	// is rewritten. Blocks compiled from those pages, or whose flag liveness scans read
+	// them, recompile on their next entry.
+	invalidate_decode_cache(start, end);
+	if (DISABLE_CODE_INVALIDATION)
+	{
+		m_cache_dirty = true;
+		return;
+	}
+
+	for (uint32_t page = start >> CODE_PAGE_SHIFT; page <= (end >> CODE_PAGE_SHIFT); page++)
+	{
+		auto found = m_code_generation.find(page);
+		if (found != m_code_generation.end())
+			found->second++;
+	}
+
+	// cached liveness results may have been worked out from the old code
+	m_drcfe->flush_flag_liveness();
+}
+
 void mb86235_device::generate_update_cycles(drcuml_block *block, compiler_state *compiler, uml::parameter param, bool allow_exception)
 {
 	/* account for cycles */
@@ -583,30 +1555,53 @@ void mb86235_device::generate_update_cycles(drcuml_block *block, compiler_state
 
 void mb86235_device::generate_ea(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int md, int arx, int ary, int disp)
 {
-	// Calculates EA into register I0
+	// Calculates EA into register I0, or into compiler->ea when it is known at compile time.
+	// AR values loaded from immediates are tracked like the PR pointers: the registers in
+	// memory are always kept up to date, so any exit sees the right value.
+	bool xknown = !DISABLE_AR_TRACKING && (compiler->arknown & (1 << arx));
+	bool yknown = !DISABLE_AR_TRACKING && (compiler->arknown & (1 << ary));
+
+	compiler->eaknown = 0;
 
 	switch (md)
 	{
 		case 0x0:	// @ARx
-			UML_MOV(block, I0, AR(arx));
-			break;
 		case 0x1:	// @ARx++
-			UML_MOV(block, I0, AR(arx));
-			UML_ADD(block, AR(arx), AR(arx), 1);
-			break;
+		case 0x2:	// @ARx--
 		case 0x3:	// @ARx++disp
-			UML_MOV(block, I0, AR(arx));
-			UML_ADD(block, AR(arx), AR(arx), disp);
+			if (xknown)
+			{
+				compiler->ea = compiler->ar[arx];
+				compiler->eaknown = 1;
+			}
+			else
+				UML_MOV(block, I0, AR(arx));
+
+			if (md != 0x0)
+				generate_ar_add(block, compiler, arx, (md == 0x1) ? 1 : (md == 0x2) ? -1 : disp);
 			break;
 		case 0x4:	// @ARx+ARy
-			UML_ADD(block, I0, AR(arx), AR(ary));
-			break;
 		case 0x5:	// @ARx+ARy++
-			UML_ADD(block, I0, AR(arx), AR(ary));
-			UML_ADD(block, AR(ary), AR(ary), 1);
+		case 0x6:	// @ARx+ARy--
+			if (xknown && yknown)
+			{
+				compiler->ea = compiler->ar[arx] + compiler->ar[ary];
+				compiler->eaknown = 1;
+			}
+			else
+				UML_ADD(block, I0, AR(arx), AR(ary));
+
+			if (md != 0x4)
+				generate_ar_add(block, compiler, ary, (md == 0x5) ? 1 : -1);
 			break;
 		case 0xa:	// @ARx+disp12
-			UML_ADD(block, I0, AR(arx), disp);
+			if (xknown)
+			{
+				compiler->ea = compiler->ar[arx] + disp;
+				compiler->eaknown = 1;
+			}
+			else
+				UML_ADD(block, I0, AR(arx), disp);
 			break;
 
 		default:
@@ -615,6 +1610,50 @@ void mb86235_device::generate_ea(drcuml_block *block, compiler_state *compiler,
 	}
 }
 
+void mb86235_device::generate_ar_add(drcuml_block *block, compiler_state *compiler, int reg, int32_t value)
+{
+	if (!DISABLE_AR_TRACKING && (compiler->arknown & (1 << reg)))
+	{
+		compiler->ar[reg] += value;
+		UML_MOV(block, AR(reg), compiler->ar[reg]);
+	}
+	else
+		UML_ADD(block, AR(reg), AR(reg), value);
+}
+
+void mb86235_device::generate_ram_read(drcuml_block *block, compiler_state *compiler, int bank)
+{
+	// Reads the word at the EA from RAM-A/RAM-B into I1. A known address inside the
+	// internal RAM is a single load from the host pointer.
+	if (compiler->eaknown)
+	{
+		if (m_internal_ram[bank] != nullptr && compiler->ea < INTERNAL_RAM_WORDS)
+		{
+			UML_MOV(block, I1, mem(&m_internal_ram[bank][compiler->ea]));                   // mov     i1,[ram + ea]
+			return;
+		}
+		UML_MOV(block, I0, compiler->ea);                                                   // mov     i0,ea
+	}
+	UML_CALLH(block, *m_read_ram[bank]);                                                    // callh   read_ram_a/b
+}
+
+void mb86235_device::generate_ram_write(drcuml_block *block, compiler_state *compiler, int bank, uml::parameter src)
+{
+	// Writes src to the word at the EA in RAM-A/RAM-B
+	if (compiler->eaknown)
+	{
+		if (m_internal_ram[bank] != nullptr && compiler->ea < INTERNAL_RAM_WORDS)
+		{
+			UML_MOV(block, mem(&m_internal_ram[bank][compiler->ea]), src);                  // mov     [ram + ea],src
+			return;
+		}
+		UML_MOV(block, I0, compiler->ea);                                                   // mov     i0,ea
+	}
+	if (!(src == I1))
+		UML_MOV(block, I1, src);                                                            // mov     i1,src
+	UML_CALLH(block, *m_write_ram[bank]);                                                   // callh   write_ram_a/b
+}
+
 
 
 void mb86235_device::generate_reg_read(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int reg, uml::parameter dst)
@@ -633,7 +1672,10 @@ void mb86235_device::generate_reg_read(drcuml_block *block, compiler_state *comp
 
 		case 0x18: case 0x19: case 0x1a: case 0x1b: case 0x1c: case 0x1d: case 0x1e: case 0x1f:
 			// AR0-7
-			UML_MOV(block, dst, AR(reg & 7));
+			if (!DISABLE_AR_TRACKING && (compiler->arknown & (1 << (reg & 7))))
+				UML_MOV(block, dst, compiler->ar[reg & 7]);
+			else
+				UML_MOV(block, dst, AR(reg & 7));
 			break;
 
 		case 0x20: case 0x21: case 0x22: case 0x23: case 0x24: case 0x25: case 0x26: case 0x27:
@@ -646,13 +1688,18 @@ void mb86235_device::generate_reg_read(drcuml_block *block, compiler_state *comp
 			UML_MOV(block, dst, AB(reg & 7));
 			break;
 
+		case 0x15:	// ST
+			generate_materialize_flags(block, compiler, false, ST_AN | ST_AZ);
+			generate_materialize_flags(block, compiler, true, ST_MN | ST_MZ);
+			UML_MOV(block, dst, FLAGS_ST);
+			break;
+
 		case 0x30:	// PR
-			UML_LOAD(block, dst, m_core->pr, PRP, SIZE_DWORD, SCALE_x4);
+			generate_pr_read(block, compiler, dst);
 			break;
 
 		case 0x31:	// FI
-			UML_CALLH(block, *m_read_fifo_in);
-			UML_MOV(block, dst, I0);
+			generate_read_fifo_in(block, dst);
 			break;
 
 		default:
@@ -688,9 +1735,24 @@ void mb86235_device::generate_reg_write(drcuml_block *block, compiler_state *com
 			UML_MOV(block, mem(&m_core->sp), src);
 			break;
 
+		case 0x15:		// ST
+			UML_MOV(block, FLAGS_ST, src);
+			UML_MOV(block, ALUKIND, LAZY_FLAGS_NONE);
+			UML_MOV(block, MULKIND, LAZY_FLAGS_NONE);
+			if (compiler->hot)
+				compiler->alukind = compiler->mulkind = LAZY_FLAGS_NONE;
+			break;
+
 		case 0x18: case 0x19: case 0x1a: case 0x1b: case 0x1c: case 0x1d: case 0x1e: case 0x1f:
 			// AR0-7
 			UML_MOV(block, AR(reg & 7), src);
+			if (src.is_immediate())
+			{
+				compiler->ar[reg & 7] = src.immediate();
+				compiler->arknown |= 1 << (reg & 7);
+			}
+			else
+				compiler->arknown &= ~(1 << (reg & 7));
 			break;
 
 		case 0x20: case 0x21: case 0x22: case 0x23: case 0x24: case 0x25: case 0x26: case 0x27:
@@ -704,12 +1766,11 @@ void mb86235_device::generate_reg_write(drcuml_block *block, compiler_state *com
 			break;
 
 		case 0x30:		// PR
-			UML_STORE(block, m_core->pr, PWP, src, SIZE_DWORD, SCALE_x4);
+			generate_pr_write(block, compiler, src);
 			break;
 
 		case 0x32:		// FO0
-			UML_MOV(block, I0, src);
-			UML_CALLH(block, *m_write_fifo_out0);
+			generate_write_fifo_out0(block, src);
 			break;
 
 		case 0x34:		// PDR
@@ -722,10 +1783,12 @@ void mb86235_device::generate_reg_write(drcuml_block *block, compiler_state *com
 
 		case 0x36:		// PRP
 			UML_MOV(block, PRP, src);
+			compiler->prp = (src.is_immediate() && src.immediate() < 24) ? src.immediate() : -1;
 			break;
 
 		case 0x37:		// PWP
 			UML_MOV(block, PWP, src);
+			compiler->pwp = (src.is_immediate() && src.immediate() < 24) ? src.immediate() : -1;
 			break;
 
 		default:
@@ -779,76 +1842,54 @@ bool mb86235_device::generate_opcode(drcuml_block *block, compiler_state *compil
 {
 	uint64_t opcode = desc->opptr.q[0];
 
-	bool fifoin_check = false;
-	bool fifoout0_check = false;
-	bool fifoout1_check = false;
-
-	// enable fifo in check if this opcode or the delay slot reads from FIFO
-	if (desc->userflags & OP_USERFLAG_FIFOIN)
-		fifoin_check = true;
-	if (desc->delayslots > 0)
-	{
-		if (desc->delay.first()->userflags & OP_USERFLAG_FIFOIN)
-			fifoin_check = true;
-	}
-
-	// enable fifoout0 check if this opcode or the delay slot writes to FIFO0
-	if (desc->userflags & OP_USERFLAG_FIFOOUT0)
-		fifoout0_check = true;
-	if (desc->delayslots > 0)
-	{
-		if (desc->delay.first()->userflags & OP_USERFLAG_FIFOOUT0)
-			fifoout0_check = true;
-	}
-
-	// enable fifoout1 check if this opcode or the delay slot writes to FIFO1
-	if (desc->userflags & OP_USERFLAG_FIFOOUT1)
-		fifoout1_check = true;
-	if (desc->delayslots > 0)
-	{
-		if (desc->delay.first()->userflags & OP_USERFLAG_FIFOOUT1)
-			fifoout1_check = true;
-	}
+	code_label repeat_loop = 0;
 
-	// insert FIFO IN check if needed
-	if (fifoin_check)
+	// a repeated op checks the FIFOs for its whole run
+	if (desc->userflags & OP_USERFLAG_REPEATED_OP)
 	{
-		code_label not_empty = compiler->labelnum++;
-		UML_CMP(block, FIFOIN_NUM, 0);
-		UML_JMPc(block, COND_G, not_empty);
-
-		UML_MOV(block, mem(&m_core->icount), 0);
-		UML_EXH(block, *m_out_of_cycles, desc->pc);
-
-		UML_LABEL(block, not_empty);
+		repeat_loop = compiler->labelnum++;
+		generate_repeat_start(block, compiler, desc, repeat_loop);
 	}
 
-	// insert FIFO OUT0 check if needed
-	if (fifoout0_check)
+	// FIFO accesses of the delay slot are checked along with the branch, so that a stall
+	// always resumes from the branch instead of from the middle of it
+	else if (!compiler->fifo_guarded && !(desc->flags & OPFLAG_IN_DELAY_SLOT))
 	{
-		code_label not_full = compiler->labelnum++;
-		UML_CMP(block, FIFOOUT0_NUM, FIFOOUT0_SIZE - 1);
-		UML_JMPc(block, COND_L, not_full);
+		int fifoin = 0, fifoout0 = 0, fifoout1 = 0;
+		count_fifo_usage(desc, &fifoin, &fifoout0, &fifoout1);
 
-		UML_MOV(block, mem(&m_core->icount), 0);
-		UML_EXH(block, *m_out_of_cycles, desc->pc);
+		if (fifoin > 0 || fifoout0 > 0 || fifoout1 > 0)
+		{
+			code_label fifo_ok = compiler->labelnum++;
+			code_label fifo_stall = compiler->labelnum++;
 
-		UML_LABEL(block, not_full);
-	}
+			// the check can stop in the middle of a sequence, resume from here; the instructions
+			// before it are charged on the way in, so an entry here only counts this one
+			if (!(desc->flags & OPFLAG_IS_BRANCH_TARGET))
+			{
+				if (compiler->cycles > desc->cycles)
+					UML_SUB(block, mem(&m_core->icount), mem(&m_core->icount), compiler->cycles - desc->cycles);
+				compiler->cycles = desc->cycles;
+				UML_HASH(block, 0, desc->pc);
+				UML_MAPVAR(block, MAPVAR_CYCLES, compiler->cycles);
+				generate_code_check(block, compiler, desc->pc);
+				compiler->prp = -1;
+				compiler->pwp = -1;
+				compiler->alukind = -1;
+				compiler->mulkind = -1;
+				compiler->arknown = 0;
+			}
 
-	// insert FIFO OUT1 check if needed
-	if (fifoout1_check)
-	{
-		code_label not_full = compiler->labelnum++;
-		UML_CMP(block, FIFOOUT1_NUM, FIFOOUT1_SIZE - 1);
-		UML_JMPc(block, COND_L, not_full);
+			generate_fifo_guard(block, fifoin, fifoout0, fifoout1, fifo_stall);
+			UML_JMP(block, fifo_ok);
 
-		UML_MOV(block, mem(&m_core->icount), 0);
-		UML_EXH(block, *m_out_of_cycles, desc->pc);
+			UML_LABEL(block, fifo_stall);
+			UML_MOV(block, mem(&m_core->icount), 0);
+			UML_EXH(block, *m_out_of_cycles, desc->pc);
 
-		UML_LABEL(block, not_full);
+			UML_LABEL(block, fifo_ok);
+		}
 	}
-	
 
 	switch ((opcode >> 61) & 7)
 	{
@@ -950,61 +1991,14 @@ bool mb86235_device::generate_opcode(drcuml_block *block, compiler_state *compil
 
 	// update PR and PW if needed
 	if ((desc->userflags & OP_USERFLAG_PR_MASK) != 0)
-	{
-		switch ((desc->userflags & OP_USERFLAG_PR_MASK) >> 8)
-		{
-			case 1:		// PR++
-				UML_ADD(block, PRP, PRP, 1);
-				UML_CMP(block, PRP, 24);
-				UML_MOVc(block, COND_GE, PRP, 0);
-				break;
-			case 2:		// PR--
-				UML_SUB(block, PRP, PRP, 1);
-				UML_CMP(block, PRP, 0);
-				UML_MOVc(block, COND_L, PRP, 23);
-				break;
-			case 3:		// PR#0
-				UML_MOV(block, PRP, 0);
-				break;
-		}
-	}
+		generate_pr_update(block, compiler, false, (desc->userflags & OP_USERFLAG_PR_MASK) >> 8);
 
 	if ((desc->userflags & OP_USERFLAG_PW_MASK) != 0)
-	{
-		switch ((desc->userflags & OP_USERFLAG_PW_MASK) >> 10)
-		{
-			case 1:		// PW++
-				UML_ADD(block, PWP, PWP, 1);
-				UML_CMP(block, PWP, 24);
-				UML_MOVc(block, COND_GE, PWP, 0);
-				break;
-			case 2:		// PW--
-				UML_SUB(block, PWP, PWP, 1);
-				UML_CMP(block, PWP, 0);
-				UML_MOVc(block, COND_L, PWP, 23);
-				break;
-			case 3:		// PW#0
-				UML_MOV(block, PWP, 0);
-				break;
-		}
-	}
+		generate_pr_update(block, compiler, true, (desc->userflags & OP_USERFLAG_PW_MASK) >> 10);
 
 	// handle repeat
 	if (desc->userflags & OP_USERFLAG_REPEATED_OP)
-	{
-		code_label no_repeat = compiler->labelnum++;
-		UML_SUB(block, RPC, RPC, 1);
-		UML_CMP(block, RPC, 0);
-		UML_JMPc(block, COND_LE, no_repeat);
-
-		generate_update_cycles(block, compiler, desc->pc, true);
-		if (desc->flags & OPFLAG_INTRABLOCK_BRANCH)
-			UML_JMP(block, desc->pc | 0x80000000);
-		else
-			UML_HASHJMP(block, 0, desc->pc, *m_nocode);
-
-		UML_LABEL(block, no_repeat);
-	}
+		generate_repeat_end(block, compiler, desc, repeat_loop);
 
 	return true;
 }
@@ -1033,7 +2027,7 @@ void mb86235_device::generate_alumul_input(drcuml_block *block, compiler_state *
 		case 0x11:	// PR++
 		case 0x12:	// PR--
 		case 0x13:	// PR#0
-			UML_LOAD(block, dst, m_core->pr, PRP, SIZE_DWORD, SCALE_x4);
+			generate_pr_read(block, compiler, dst);
 			break;
 
 		case 0x18:	// 0 / -1.0E+0
@@ -1113,18 +2107,189 @@ uml::parameter mb86235_device::get_alu1_input(int reg)
 
 uml::parameter mb86235_device::get_mul1_input(int reg)
 {
-	switch (reg)
+	switch (reg)
+	{
+		case 0x00: case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x07:
+			return MA(reg & 7);
+
+		case 0x08: case 0x09: case 0x0a: case 0x0b: case 0x0c: case 0x0d: case 0x0e: case 0x0f:
+			return MB(reg & 7);
+	}
+	return uml::parameter(0);
+}
+
+
+
+void mb86235_device::generate_update_flags(drcuml_block *block, uint32_t mask, condition_t ncond, uint32_t nflag, condition_t zcond, uint32_t zflag, uint32_t vflag, uint32_t setflags)
+{
+	// Gathers the sign/zero conditions of the last compare (and the overflow bit in I2 if vflag
+	// is given) into I0, then writes the flags in mask to ST with one read-modify-write.
+	// Flags in mask that are not produced here are cleared. Clobbers I0 and I1.
+	if (mask == 0)
+		return;
+
+	if (nflag != 0)
+		UML_SETc(block, ncond, I0);
+	if (zflag != 0)
+		UML_SETc(block, zcond, I1);
+
+	if (nflag != 0)
+		UML_SHL(block, I0, I0, flag_shift(nflag));
+	else
+		UML_MOV(block, I0, 0);
+	if (zflag != 0)
+		UML_ROLINS(block, I0, I1, flag_shift(zflag), zflag);
+	if (vflag != 0)
+		UML_ROLINS(block, I0, I2, flag_shift(vflag), vflag);
+	if (setflags != 0)
+		UML_OR(block, I0, I0, setflags);
+
+	UML_ROLINS(block, FLAGS_ST, I0, 0, mask);
+}
+
+void mb86235_device::generate_set_overflow(drcuml_block *block, uint32_t flag)
+{
+	// ORs the overflow bit in I2 into AV or MV, which stay set until ST is written
+	if (flag == 0)
+		return;
+
+	UML_SHL(block, I2, I2, flag_shift(flag));
+	UML_OR(block, FLAGS_ST, FLAGS_ST, I2);
+}
+
+void mb86235_device::generate_lazy_flags(drcuml_block *block, compiler_state *compiler, bool mul, int kind, uml::parameter result, uint32_t mask)
+{
+	// Records an ALU or MUL result so that its sign/zero flags can be computed later, only when
+	// a condition or an ST read actually looks at them (see generate_materialize_flags)
+	if (mask == 0)
+		return;
+
+	if (DISABLE_LAZY_FLAGS)
+	{
+		if (kind == LAZY_FLAGS_FP)
+		{
+			UML_FSCMP(block, result, mem(&m_core->fp0));
+			generate_update_flags(block, mask, COND_C, mul ? ST_MN : ST_AN, COND_Z, mul ? ST_MZ : ST_AZ, 0, 0);
+		}
+		else
+		{
+			UML_CMP(block, result, 0);
+			generate_update_flags(block, mask, COND_L, mul ? ST_MN : ST_AN, COND_Z, mul ? ST_MZ : ST_AZ, 0, 0);
+		}
+		return;
+	}
+
+	if (kind == LAZY_FLAGS_FP)
+		UML_ICOPYFS(block, mul ? MULRES : ALURES, result);
+	else
+		UML_MOV(block, mul ? MULRES : ALURES, result);
+
+	// the kind in memory is only stored again if it changes
+	int32_t &known = mul ? compiler->mulkind : compiler->alukind;
+	if (known != kind)
+		UML_MOV(block, mul ? MULKIND : ALUKIND, kind);
+	if (compiler->hot)
+		known = kind;
+}
+
+void mb86235_device::generate_clear_lazy_flags(drcuml_block *block, compiler_state *compiler, bool mul, uint32_t mask)
+{
+	// the op wrote its sign/zero flags straight to ST, drop any pending lazy result
+	if (!DISABLE_LAZY_FLAGS && (mask & (mul ? (ST_MN | ST_MZ) : (ST_AN | ST_AZ))) != 0)
+	{
+		int32_t &known = mul ? compiler->mulkind : compiler->alukind;
+		if (known != LAZY_FLAGS_NONE)
+			UML_MOV(block, mul ? MULKIND : ALUKIND, LAZY_FLAGS_NONE);
+		if (compiler->hot)
+			known = LAZY_FLAGS_NONE;
+	}
+}
+
+void mb86235_device::generate_materialize_flags(drcuml_block *block, compiler_state *compiler, bool mul, uint32_t mask)
+{
+	// Computes the sign/zero flags in mask from the pending ALU or MUL result into ST.
+	// The pending result stays valid, so this can be repeated for other flags. Clobbers I0/I1/F0.
+	if (DISABLE_LAZY_FLAGS || mask == 0)
+		return;
+
+	code_label fp = compiler->labelnum++;
+	code_label done = compiler->labelnum++;
+	uint32_t nflag = mul ? ST_MN : ST_AN;
+	uint32_t zflag = mul ? ST_MZ : ST_AZ;
+	int32_t known = mul ? compiler->mulkind : compiler->alukind;
+
+	// hot blocks know the kind when the result came from earlier in the sequence
+	if (known == LAZY_FLAGS_NONE)
+		return;
+	if (known == LAZY_FLAGS_INT)
+	{
+		UML_CMP(block, mul ? MULRES : ALURES, 0);
+		generate_update_flags(block, mask, COND_L, nflag, COND_Z, zflag, 0, 0);
+		return;
+	}
+	if (known == LAZY_FLAGS_FP)
+	{
+		UML_FSCOPYI(block, F0, mul ? MULRES : ALURES);
+		UML_FSCMP(block, F0, mem(&m_core->fp0));
+		generate_update_flags(block, mask, COND_C, nflag, COND_Z, zflag, 0, 0);
+		return;
+	}
+
+	UML_CMP(block, mul ? MULKIND : ALUKIND, LAZY_FLAGS_FP);
+	UML_JMPc(block, COND_E, fp);
+	UML_CMP(block, mul ? MULKIND : ALUKIND, LAZY_FLAGS_INT);
+	UML_JMPc(block, COND_NE, done);
+
+	UML_CMP(block, mul ? MULRES : ALURES, 0);
+	generate_update_flags(block, mask, COND_L, nflag, COND_Z, zflag, 0, 0);
+	UML_JMP(block, done);
+
+	UML_LABEL(block, fp);
+	UML_FSCOPYI(block, F0, mul ? MULRES : ALURES);
+	UML_FSCMP(block, F0, mem(&m_core->fp0));
+	generate_update_flags(block, mask, COND_C, nflag, COND_Z, zflag, 0, 0);
+
+	UML_LABEL(block, done);
+}
+
+/*-------------------------------------------------
+materialize_lazy_flags - compute the pending ALU
+and MUL sign/zero flags into ST, for the debugger
+-------------------------------------------------*/
+
+void mb86235_device::materialize_lazy_flags()
+{
+	// same as generate_materialize_flags, the pending results stay valid
+	for (int mul = 0; mul < 2; mul++)
 	{
-		case 0x00: case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x07:
-			return MA(reg & 7);
+		uint32_t kind = mul ? m_core->mulkind : m_core->alukind;
+		uint32_t res = mul ? m_core->mulres : m_core->alures;
+		uint32_t nflag = mul ? ST_MN : ST_AN;
+		uint32_t zflag = mul ? ST_MZ : ST_AZ;
+		bool n, z;
 
-		case 0x08: case 0x09: case 0x0a: case 0x0b: case 0x0c: case 0x0d: case 0x0e: case 0x0f:
-			return MB(reg & 7);
+		if (kind == LAZY_FLAGS_INT)
+		{
+			n = int32_t(res) < 0;
+			z = res == 0;
+		}
+		else if (kind == LAZY_FLAGS_FP)
+		{
+			n = u2f(res) < m_core->fp0;
+			z = u2f(res) == m_core->fp0;
+		}
+		else
+			continue;
+
+		m_core->st = (m_core->st & ~(nflag | zflag)) | (n ? nflag : 0) | (z ? zflag : 0);
 	}
-	return uml::parameter(0);
 }
 
-
+void mb86235_device::drop_lazy_flags()
+{
+	m_core->alukind = LAZY_FLAGS_NONE;
+	m_core->mulkind = LAZY_FLAGS_NONE;
+}
 
 void mb86235_device::generate_alu(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int aluop, bool alutemp)
 {
@@ -1136,105 +2301,117 @@ void mb86235_device::generate_alu(drcuml_block *block, compiler_state *compiler,
 	switch (op)	
 	{
 		case 0x00:		// FADD
+		{
+			uint32_t flags = FLAG_IF_REQUIRED(AN) | FLAG_IF_REQUIRED(AZ);
 			generate_alumul_input(block, compiler, desc, i2, I0, true, false);
 			UML_FSCOPYI(block, F0, I0);
 			UML_FSCOPYI(block, F1, get_alu1_input(i1));
 			UML_FSADD(block, F0, F0, F1);
 			UML_ICOPYFS(block, alutemp ? mem(&m_core->alutemp) : get_alu_output(io), F0);
-			if (AN_CALC_REQUIRED || AZ_CALC_REQUIRED)
-				UML_FSCMP(block, F0, mem(&m_core->fp0));
-			if (AN_CALC_REQUIRED) UML_SETc(block, COND_C, FLAGS_AN);
-			if (AZ_CALC_REQUIRED) UML_SETc(block, COND_Z, FLAGS_AZ);
+			generate_lazy_flags(block, compiler, false, LAZY_FLAGS_FP, F0, flags);
 			// TODO: AV flag
 			// TODO: AU flag
 			// TODO: AD flag
 			break;
+		}
 
 		case 0x02:		// FSUB
+		{
+			uint32_t flags = FLAG_IF_REQUIRED(AN) | FLAG_IF_REQUIRED(AZ);
 			generate_alumul_input(block, compiler, desc, i2, I0, true, false);
 			UML_FSCOPYI(block, F0, I0);
 			UML_FSCOPYI(block, F1, get_alu1_input(i1));
 			UML_FSSUB(block, F0, F0, F1);
 			UML_ICOPYFS(block, alutemp ? mem(&m_core->alutemp) : get_alu_output(io), F0);
-			if (AN_CALC_REQUIRED || AZ_CALC_REQUIRED)
-				UML_FSCMP(block, F0, mem(&m_core->fp0));
-			if (AN_CALC_REQUIRED) UML_SETc(block, COND_C, FLAGS_AN);
-			if (AZ_CALC_REQUIRED) UML_SETc(block, COND_Z, FLAGS_AZ);
+			generate_lazy_flags(block, compiler, false, LAZY_FLAGS_FP, F0, flags);
 			// TODO: AV flag
 			// TODO: AU flag
 			// TODO: AD flag
 			break;
+		}
 
 		case 0x04:		// FCMP
+		{
+			uint32_t flags = FLAG_IF_REQUIRED(AN) | FLAG_IF_REQUIRED(AZ);
 			generate_alumul_input(block, compiler, desc, i2, I0, true, false);
 			UML_FSCOPYI(block, F0, I0);
 			UML_FSCOPYI(block, F1, get_alu1_input(i1));
 			UML_FSCMP(block, F0, F1);
-			if (AN_CALC_REQUIRED) UML_SETc(block, COND_C, FLAGS_AN);
-			if (AZ_CALC_REQUIRED) UML_SETc(block, COND_Z, FLAGS_AZ);
+			generate_update_flags(block, flags, COND_C, ST_AN, COND_Z, ST_AZ, 0, 0);
+			generate_clear_lazy_flags(block, compiler, false, flags);
 			// TODO: AV flag
 			// TODO: AU flag
 			// TODO: AD flag
 			break;
+		}
 
 		case 0x05:		// FABS
+		{
+			uint32_t flags = FLAG_IF_REQUIRED(AN) | FLAG_IF_REQUIRED(AZ);
 			UML_AND(block, alutemp ? mem(&m_core->alutemp) : get_alu_output(io), get_alu1_input(i1), 0x7fffffff);
-			if (AZ_CALC_REQUIRED) UML_SETc(block, COND_Z, FLAGS_AZ);
-			if (AN_CALC_REQUIRED) UML_MOV(block, FLAGS_AN, 0);
+			generate_update_flags(block, flags, COND_S, 0, COND_Z, ST_AZ, 0, 0);		// AN is always cleared
+			generate_clear_lazy_flags(block, compiler, false, flags);
 			// TODO: AD flag
 			break;
+		}
 
 		case 0x06:		// FABC
+		{
+			uint32_t flags = FLAG_IF_REQUIRED(AN) | FLAG_IF_REQUIRED(AZ) | FLAG_IF_REQUIRED(AU);
 			generate_alumul_input(block, compiler, desc, i2, I0, true, false);
 			UML_AND(block, I0, I0, 0x7fffffff);
 			UML_AND(block, I1, get_alu1_input(i1), 0x7fffffff);
 			UML_FSCOPYI(block, F0, I0);
 			UML_FSCOPYI(block, F1, I1);
 			UML_FSCMP(block, F0, F1);
-			if (AN_CALC_REQUIRED) UML_SETc(block, COND_C, FLAGS_AN);
-			if (AZ_CALC_REQUIRED) UML_SETc(block, COND_Z, FLAGS_AZ);
-			if (AU_CALC_REQUIRED) UML_MOV(block, FLAGS_AU, 1);
+			generate_update_flags(block, flags, COND_C, ST_AN, COND_Z, ST_AZ, 0, ST_AU);
+			generate_clear_lazy_flags(block, compiler, false, flags);
 			// TODO: AD flag
 			break;
+		}
 
 		case 0x07:		// NOP
 			break;
 
 		case 0x0a:		// FRCP
+		{
+			uint32_t flags = FLAG_IF_REQUIRED(AN) | FLAG_IF_REQUIRED(AZ);
 			UML_FSCOPYI(block, F0, get_alu1_input(i1));
 			UML_FSRECIP(block, F0, F0);
 			UML_ICOPYFS(block, alutemp ? mem(&m_core->alutemp) : get_alu_output(io), F0);
-			if (AN_CALC_REQUIRED || AZ_CALC_REQUIRED)
-				UML_FSCMP(block, F0, mem(&m_core->fp0));
-			if (AN_CALC_REQUIRED) UML_SETc(block, COND_C, FLAGS_AN);
-			if (AZ_CALC_REQUIRED) UML_SETc(block, COND_Z, FLAGS_AZ);
+			generate_lazy_flags(block, compiler, false, LAZY_FLAGS_FP, F0, flags);
 			// TODO: AD flag
 			// TODO: AU flag
 			// TODO: ZD flag (zero divide)
 			break;
+		}
 
 		case 0x0b:		// FRSQ
+		{
+			uint32_t flags = FLAG_IF_REQUIRED(AN) | FLAG_IF_REQUIRED(AZ);
 			UML_FSCOPYI(block, F0, get_alu1_input(i1));
 			UML_FSRSQRT(block, F0, F0);
 			UML_ICOPYFS(block, alutemp ? mem(&m_core->alutemp) : get_alu_output(io), F0);
-			if (AN_CALC_REQUIRED) UML_MOV(block, FLAGS_AN, 0);
-			if (AZ_CALC_REQUIRED) UML_MOV(block, FLAGS_AZ, 0);
+			generate_update_flags(block, flags, COND_C, 0, COND_Z, 0, 0, 0);				// AN and AZ are always cleared
+			generate_clear_lazy_flags(block, compiler, false, flags);
 			// TODO: AD flag
 			// TODO: NR flag (Axx <= 0)
 			break;
+		}
 
 		case 0x0d:		// CIF
+		{
+			uint32_t flags = FLAG_IF_REQUIRED(AN) | FLAG_IF_REQUIRED(AZ);
 			generate_alumul_input(block, compiler, desc, i1, I1, true, false);
 			UML_FSFRINT(block, F0, I1, SIZE_DWORD);
-			if (AZ_CALC_REQUIRED || AN_CALC_REQUIRED)
-				UML_CMP(block, I1, 0);
-			if (AN_CALC_REQUIRED) UML_SETc(block, COND_L, FLAGS_AN);
-			if (AZ_CALC_REQUIRED) UML_SETc(block, COND_E, FLAGS_AZ);
+			generate_lazy_flags(block, compiler, false, LAZY_FLAGS_INT, I1, flags);
 			UML_ICOPYFS(block, alutemp ? mem(&m_core->alutemp) : get_alu_output(io), F0);
 			break;
+		}
 
 		case 0x0e:		// CFI
 		{
+			uint32_t flags = FLAG_IF_REQUIRED(AN) | FLAG_IF_REQUIRED(AZ) | FLAG_IF_REQUIRED(AV);
 			code_label truncate = compiler->labelnum++;
 			code_label end = compiler->labelnum++;
 			UML_FSCOPYI(block, F0, get_alu1_input(i1));
@@ -1245,103 +2422,90 @@ void mb86235_device::generate_alu(drcuml_block *block, compiler_state *compiler,
 			UML_LABEL(block, truncate);
 			UML_FSTOINT(block, I0, F0, SIZE_DWORD, ROUND_TRUNC);
 			UML_LABEL(block, end);
-			
-			UML_CMP(block, I0, 0xff800000);
-			UML_MOVc(block, COND_L, I0, 0xff800000);
-			if (AV_CALC_REQUIRED) UML_MOVc(block, COND_L, FLAGS_AV, 1);
-			UML_CMP(block, I0, 0x007fffff);
-			UML_MOVc(block, COND_G, I0, 0x007fffff);
-			if (AV_CALC_REQUIRED) UML_MOVc(block, COND_G, FLAGS_AV, 1);
-			if (AN_CALC_REQUIRED || AZ_CALC_REQUIRED)
-				UML_CMP(block, I0, 0);
-			if (AN_CALC_REQUIRED) UML_SETc(block, COND_L, FLAGS_AN);
-			if (AZ_CALC_REQUIRED) UML_SETc(block, COND_Z, FLAGS_AZ);
+
+			generate_saturate(block, (flags & ST_AV) != 0);
 			UML_MOV(block, alutemp ? mem(&m_core->alutemp) : get_alu_output(io), I0);
+			generate_lazy_flags(block, compiler, false, LAZY_FLAGS_INT, I0, flags & (ST_AN | ST_AZ));
+			generate_set_overflow(block, flags & ST_AV);
 			break;
 		}
 
 		case 0x10:		// ADD
+		{
+			uint32_t flags = FLAG_IF_REQUIRED(AN) | FLAG_IF_REQUIRED(AZ) | FLAG_IF_REQUIRED(AV);
 			generate_alumul_input(block, compiler, desc, i2, I1, false, false);
 			UML_ADD(block, I0, I1, get_alu1_input(i1));
-			if (AZ_CALC_REQUIRED) UML_SETc(block, COND_Z, FLAGS_AZ);
-			if (AN_CALC_REQUIRED) UML_SETc(block, COND_S, FLAGS_AN);
-			UML_CMP(block, I0, 0xff800000);
-			UML_MOVc(block, COND_L, I0, 0xff800000);
-			if (AV_CALC_REQUIRED) UML_MOVc(block, COND_L, FLAGS_AV, 1);
-			UML_CMP(block, I0, 0x007fffff);
-			UML_MOVc(block, COND_G, I0, 0x007fffff);
-			if (AV_CALC_REQUIRED) UML_MOVc(block, COND_G, FLAGS_AV, 1);
+			generate_saturate(block, (flags & ST_AV) != 0);
 			UML_MOV(block, alutemp ? mem(&m_core->alutemp) : get_alu_output(io), I0);
+			generate_lazy_flags(block, compiler, false, LAZY_FLAGS_INT, I0, flags & (ST_AN | ST_AZ));
+			generate_set_overflow(block, flags & ST_AV);
 			break;
+		}
 
 		case 0x12:		// SUB
+		{
+			uint32_t flags = FLAG_IF_REQUIRED(AN) | FLAG_IF_REQUIRED(AZ) | FLAG_IF_REQUIRED(AV);
 			generate_alumul_input(block, compiler, desc, i2, I1, false, false);
 			UML_SUB(block, I0, I1, get_alu1_input(i1));
-			if (AZ_CALC_REQUIRED) UML_SETc(block, COND_Z, FLAGS_AZ);
-			if (AN_CALC_REQUIRED) UML_SETc(block, COND_S, FLAGS_AN);
-			UML_CMP(block, I0, 0xff800000);
-			UML_MOVc(block, COND_L, I0, 0xff800000);
-			if (AV_CALC_REQUIRED) UML_MOVc(block, COND_L, FLAGS_AV, 1);
-			UML_CMP(block, I0, 0x007fffff);
-			UML_MOVc(block, COND_G, I0, 0x007fffff);
-			if (AV_CALC_REQUIRED) UML_MOVc(block, COND_G, FLAGS_AV, 1);
+			generate_saturate(block, (flags & ST_AV) != 0);
 			UML_MOV(block, alutemp ? mem(&m_core->alutemp) : get_alu_output(io), I0);
+			generate_lazy_flags(block, compiler, false, LAZY_FLAGS_INT, I0, flags & (ST_AN | ST_AZ));
+			generate_set_overflow(block, flags & ST_AV);
 			break;
+		}
 
 		case 0x14:		// CMP
+		{
+			uint32_t flags = FLAG_IF_REQUIRED(AN) | FLAG_IF_REQUIRED(AZ) | FLAG_IF_REQUIRED(AV);
 			generate_alumul_input(block, compiler, desc, i2, I1, false, false);
 			UML_SUB(block, I0, I1, get_alu1_input(i1));
-			if (AZ_CALC_REQUIRED) UML_SETc(block, COND_Z, FLAGS_AZ);
-			if (AN_CALC_REQUIRED) UML_SETc(block, COND_S, FLAGS_AN);
-			if (AV_CALC_REQUIRED)
-			{
-				UML_CMP(block, I0, 0xff800000);
-				UML_MOVc(block, COND_L, FLAGS_AV, 1);
-				UML_CMP(block, I0, 0x007fffff);
-				UML_MOVc(block, COND_G, FLAGS_AV, 1);
-			}
+			if (flags & ST_AV)
+				generate_saturate(block, true);
+			generate_lazy_flags(block, compiler, false, LAZY_FLAGS_INT, I0, flags & (ST_AN | ST_AZ));
+			generate_set_overflow(block, flags & ST_AV);
 			break;
+		}
 
 		case 0x16:		// ATR
 			UML_MOV(block, alutemp ? mem(&m_core->alutemp) : get_alu_output(io), get_alu1_input(i1));
 			break;
 
 		case 0x18:		// AND
+		{
+			uint32_t flags = FLAG_IF_REQUIRED(AN) | FLAG_IF_REQUIRED(AZ) | FLAG_IF_REQUIRED(AV) | FLAG_IF_REQUIRED(AU);
 			generate_alumul_input(block, compiler, desc, i2, I0, false, false);
 			UML_AND(block, alutemp ? mem(&m_core->alutemp) : get_alu_output(io), I0, get_alu1_input(i1));
-			if (AN_CALC_REQUIRED) UML_SETc(block, COND_S, FLAGS_AN);
-			if (AZ_CALC_REQUIRED) UML_SETc(block, COND_Z, FLAGS_AZ);
-			if (AV_CALC_REQUIRED) UML_MOV(block, FLAGS_AV, 0);
-			if (AU_CALC_REQUIRED) UML_MOV(block, FLAGS_AU, 0);
+			generate_lazy_flags(block, compiler, false, LAZY_FLAGS_INT, alutemp ? mem(&m_core->alutemp) : get_alu_output(io), flags & (ST_AN | ST_AZ));
+			generate_update_flags(block, flags & (ST_AV | ST_AU), COND_S, 0, COND_Z, 0, 0, 0);		// AV and AU are cleared
 			break;
+		}
 
 		case 0x1c:		// LSR
+		{
+			uint32_t flags = FLAG_IF_REQUIRED(AN) | FLAG_IF_REQUIRED(AZ) | FLAG_IF_REQUIRED(AV) | FLAG_IF_REQUIRED(AU);
 			generate_alumul_input(block, compiler, desc, i1, I0, false, false);
 			UML_SHR(block, I0, I0, i2);
-			if (AZ_CALC_REQUIRED || AN_CALC_REQUIRED)
-				UML_CMP(block, I0, 0);
-			if (AN_CALC_REQUIRED) UML_SETc(block, COND_L, FLAGS_AN);
-			if (AZ_CALC_REQUIRED) UML_SETc(block, COND_E, FLAGS_AZ);
-			if (AV_CALC_REQUIRED) UML_MOV(block, FLAGS_AV, 0);
-			if (AU_CALC_REQUIRED) UML_MOV(block, FLAGS_AU, 0);
 			UML_MOV(block, alutemp ? mem(&m_core->alutemp) : get_alu_output(io), I0);
+			generate_lazy_flags(block, compiler, false, LAZY_FLAGS_INT, I0, flags & (ST_AN | ST_AZ));
+			generate_update_flags(block, flags & (ST_AV | ST_AU), COND_L, 0, COND_E, 0, 0, 0);		// AV and AU are cleared
 			break;
+		}
 
 		case 0x1d:		// LSL
+		{
+			uint32_t flags = FLAG_IF_REQUIRED(AN) | FLAG_IF_REQUIRED(AZ) | FLAG_IF_REQUIRED(AV) | FLAG_IF_REQUIRED(AU);
 			generate_alumul_input(block, compiler, desc, i1, I0, false, false);
 			UML_SHL(block, I0, I0, i2);
-			if (AZ_CALC_REQUIRED || AN_CALC_REQUIRED)
-				UML_CMP(block, I0, 0);
-			if (AN_CALC_REQUIRED) UML_SETc(block, COND_L, FLAGS_AN);
-			if (AZ_CALC_REQUIRED) UML_SETc(block, COND_E, FLAGS_AZ);
-			if (AV_CALC_REQUIRED) UML_MOV(block, FLAGS_AV, 0);
-			if (AU_CALC_REQUIRED) UML_MOV(block, FLAGS_AU, 0);
 			UML_MOV(block, alutemp ? mem(&m_core->alutemp) : get_alu_output(io), I0);
+			generate_lazy_flags(block, compiler, false, LAZY_FLAGS_INT, I0, flags & (ST_AN | ST_AZ));
+			generate_update_flags(block, flags & (ST_AV | ST_AU), COND_L, 0, COND_E, 0, 0, 0);		// AV and AU are cleared
 			break;
+		}
 
 		default:
 			UML_MOV(block, mem(&m_core->pc), desc->pc);
 			UML_MOV(block, mem(&m_core->arg0), op);
+			save_fast_iregs(block);
 			UML_CALLC(block, cfunc_unimplemented_alu, this);
 			break;
 	}
@@ -1357,14 +2521,12 @@ void mb86235_device::generate_mul(drcuml_block *block, compiler_state *compiler,
 	if (m)
 	{
 		// FMUL
+		uint32_t flags = FLAG_IF_REQUIRED(MN) | FLAG_IF_REQUIRED(MZ);
 		generate_alumul_input(block, compiler, desc, i2, I1, true, true);
 		UML_FSCOPYI(block, F1, I1);
 		UML_FSCOPYI(block, F0, get_mul1_input(i1));
 		UML_FSMUL(block, F1, F0, F1);
-		if (MZ_CALC_REQUIRED || MN_CALC_REQUIRED)
-			UML_FSCMP(block, F1, mem(&m_core->fp0));
-		if (MZ_CALC_REQUIRED) UML_SETc(block, COND_E, FLAGS_MZ);
-		if (MN_CALC_REQUIRED) UML_SETc(block, COND_C, FLAGS_MN);
+		generate_lazy_flags(block, compiler, true, LAZY_FLAGS_FP, F1, flags);
 		// TODO: MV flag
 		// TODO: MU flag
 		// TODO: MD flag
@@ -1373,21 +2535,51 @@ void mb86235_device::generate_mul(drcuml_block *block, compiler_state *compiler,
 	else
 	{
 		// MUL
+		uint32_t flags = FLAG_IF_REQUIRED(MN) | FLAG_IF_REQUIRED(MZ) | FLAG_IF_REQUIRED(MV);
 		generate_alumul_input(block, compiler, desc, i2, I1, false, true);
 		UML_MULS(block, I0, I0, I1, get_mul1_input(i1));
-		if (MZ_CALC_REQUIRED) UML_SETc(block, COND_Z, FLAGS_MZ);
-		if (MN_CALC_REQUIRED) UML_SETc(block, COND_S, FLAGS_MN);
-		UML_CMP(block, I0, 0xff800000);
-		UML_MOVc(block, COND_L, I0, 0xff800000);
-		if (MV_CALC_REQUIRED) UML_MOVc(block, COND_L, FLAGS_MV, 1);
-		UML_CMP(block, I0, 0x007fffff);
-		UML_MOVc(block, COND_G, I0, 0x007fffff);
-		if (MV_CALC_REQUIRED) UML_MOVc(block, COND_G, FLAGS_MV, 1);
+		generate_saturate(block, (flags & ST_MV) != 0);
 		UML_MOV(block, multemp ? mem(&m_core->multemp) : get_alu_output(io), I0);
+		generate_lazy_flags(block, compiler, true, LAZY_FLAGS_INT, I0, flags & (ST_MN | ST_MZ));
+		generate_set_overflow(block, flags & ST_MV);
+	}
+}
+
+void mb86235_device::generate_saturate(drcuml_block *block, bool overflow)
+{
+	// Clamps I0 to the 24-bit signed range. If overflow is set, I2 = 1 when clamping happened (clobbers I1)
+	UML_CMP(block, I0, 0xff800000);
+	UML_MOVc(block, COND_L, I0, 0xff800000);
+	if (overflow) UML_SETc(block, COND_L, I2);
+	UML_CMP(block, I0, 0x007fffff);
+	UML_MOVc(block, COND_G, I0, 0x007fffff);
+	if (overflow)
+	{
+		UML_SETc(block, COND_G, I1);
+		UML_OR(block, I2, I2, I1);
 	}
 }
 
 
+void mb86235_device::generate_static_jump(drcuml_block *block, compiler_state *compiler, const opcode_desc *desclist, offs_t pc)
+{
+	// Jumps to a fixed pc. Sequence heads in this block are labelled, so those are a plain jump.
+	// Anything else is a hashjmp with constant mode and pc, which the backends compile as a
+	// jump through that pc's slot in the hash table. The slot points at nocode until the target
+	// is compiled and then straight at its code, so once the target exists the exit is linked
+	// to it without a lookup. A cache flush resets the table, which undoes every link.
+	for (const opcode_desc *curdesc = desclist; curdesc != nullptr && curdesc->pc < compiler->splitpc; curdesc = curdesc->next())
+	{
+		if (curdesc->pc == pc && (curdesc->flags & OPFLAG_IS_BRANCH_TARGET))
+		{
+			UML_JMP(block, pc | 0x80000000);                                                // jmp     pc | 0x80000000
+			return;
+		}
+	}
+
+	UML_HASHJMP(block, 0, pc, *m_nocode);                                                   // hashjmp 0,pc,nocode
+}
+
 void mb86235_device::generate_branch(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc)
 {
 	// I0 = target pc for dynamic branches
@@ -1407,7 +2599,7 @@ void mb86235_device::generate_branch(drcuml_block *block, compiler_state *compil
 	if (desc->targetpc != BRANCH_TARGET_DYNAMIC)
 	{
 		generate_update_cycles(block, &compiler_temp, desc->targetpc, true);
-		if (desc->flags & OPFLAG_INTRABLOCK_BRANCH)
+		if ((desc->flags & OPFLAG_INTRABLOCK_BRANCH) && desc->targetpc < compiler->splitpc)
 			UML_JMP(block, desc->targetpc | 0x80000000);                                // jmp      targetpc | 0x80000000
 		else
 			UML_HASHJMP(block, 0, desc->targetpc, *m_nocode);                           // hashjmp  0,targetpc,nocode
@@ -1427,6 +2619,36 @@ void mb86235_device::generate_branch(drcuml_block *block, compiler_state *compil
 }
 
 
+void mb86235_device::generate_push_pc(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc)
+{
+	// pushes the return address (past the delay slot) to the PC stack
+	code_label no_overflow = compiler->labelnum++;
+	UML_CMP(block, mem(&m_core->pcs_ptr), 4);
+	UML_JMPc(block, COND_L, no_overflow);
+	UML_MOV(block, mem(&m_core->pc), desc->pc);
+	save_fast_iregs(block);
+	UML_CALLC(block, cfunc_pcs_overflow, this);
+
+	UML_LABEL(block, no_overflow);
+	UML_STORE(block, m_core->pcs, mem(&m_core->pcs_ptr), desc->pc + 2, SIZE_DWORD, SCALE_x4);
+	UML_ADD(block, mem(&m_core->pcs_ptr), mem(&m_core->pcs_ptr), 1);
+}
+
+void mb86235_device::generate_pop_pc(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc)
+{
+	// pops the PC stack into I0
+	code_label no_underflow = compiler->labelnum++;
+	UML_CMP(block, mem(&m_core->pcs_ptr), 0);
+	UML_JMPc(block, COND_G, no_underflow);
+	UML_MOV(block, mem(&m_core->pc), desc->pc);
+	save_fast_iregs(block);
+	UML_CALLC(block, cfunc_pcs_underflow, this);
+
+	UML_LABEL(block, no_underflow);
+	UML_SUB(block, mem(&m_core->pcs_ptr), mem(&m_core->pcs_ptr), 1);
+	UML_LOAD(block, I0, m_core->pcs, mem(&m_core->pcs_ptr), SIZE_DWORD, SCALE_x4);
+}
+
 void mb86235_device::generate_branch_target(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int type, int ef2)
 {
 	// Calculates dynamic targets into I0
@@ -1438,7 +2660,10 @@ void mb86235_device::generate_branch_target(drcuml_block *block, compiler_state
 		case 0x2:			// ARx
 		{
 			int reg = (ef2 >> 6) & 7;
-			UML_MOV(block, I0, AR(reg));
+			if (!DISABLE_AR_TRACKING && (compiler->arknown & (1 << reg)))
+				UML_MOV(block, I0, compiler->ar[reg]);
+			else
+				UML_MOV(block, I0, AR(reg));
 			break;
 		}
 		case 0x4:			// Axx
@@ -1459,68 +2684,34 @@ void mb86235_device::generate_branch_target(drcuml_block *block, compiler_state
 
 void mb86235_device::generate_condition(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int cc, bool n, uml::code_label skip_label, bool condtemp)
 {
+	uint32_t flag;
+
 	switch (cc)
 	{
-		case 0x00:		// MN
-			UML_CMP(block, condtemp ? mem(&m_core->condtemp) : FLAGS_MN, 0);
-			UML_JMPc(block, n ? COND_NE : COND_E, skip_label);
-			break;
-		case 0x01:		// MZ
-			UML_CMP(block, condtemp ? mem(&m_core->condtemp) : FLAGS_MZ, 0);
-			UML_JMPc(block, n ? COND_NE : COND_E, skip_label);
-			break;
-		case 0x02:		// MV
-			UML_CMP(block, condtemp ? mem(&m_core->condtemp) : FLAGS_MV, 0);
-			UML_JMPc(block, n ? COND_NE : COND_E, skip_label);
-			break;
-		case 0x03:		// MU
-			UML_CMP(block, condtemp ? mem(&m_core->condtemp) : FLAGS_MU, 0);
-			UML_JMPc(block, n ? COND_NE : COND_E, skip_label);
-			break;
-		case 0x04:		// ZD
-			UML_CMP(block, condtemp ? mem(&m_core->condtemp) : FLAGS_ZD, 0);
-			UML_JMPc(block, n ? COND_NE : COND_E, skip_label);
-			break;
-		case 0x05:		// NR
-			UML_CMP(block, condtemp ? mem(&m_core->condtemp) : FLAGS_NR, 0);
-			UML_JMPc(block, n ? COND_NE : COND_E, skip_label);
-			break;
-		case 0x06:		// IL
-			UML_CMP(block, condtemp ? mem(&m_core->condtemp) : FLAGS_IL, 0);
-			UML_JMPc(block, n ? COND_NE : COND_E, skip_label);
-			break;
-		case 0x07:		// ZC
-			UML_CMP(block, condtemp ? mem(&m_core->condtemp) : FLAGS_ZC, 0);
-			UML_JMPc(block, n ? COND_NE : COND_E, skip_label);
-			break;
-		case 0x08:		// AN
-			UML_CMP(block, condtemp ? mem(&m_core->condtemp) : FLAGS_AN, 0);
-			UML_JMPc(block, n ? COND_NE : COND_E, skip_label);
-			break;
-		case 0x09:		// AZ
-			UML_CMP(block, condtemp ? mem(&m_core->condtemp) : FLAGS_AZ, 0);
-			UML_JMPc(block, n ? COND_NE : COND_E, skip_label);
-			break;
-		case 0x0a:		// AV
-			UML_CMP(block, condtemp ? mem(&m_core->condtemp) : FLAGS_AV, 0);
-			UML_JMPc(block, n ? COND_NE : COND_E, skip_label);
-			break;
-		case 0x0b:		// AU
-			UML_CMP(block, condtemp ? mem(&m_core->condtemp) : FLAGS_AU, 0);
-			UML_JMPc(block, n ? COND_NE : COND_E, skip_label);
-			break;
-		case 0x0c:		// MD
-			UML_CMP(block, condtemp ? mem(&m_core->condtemp) : FLAGS_MD, 0);
-			UML_JMPc(block, n ? COND_NE : COND_E, skip_label);
-			break;
-		case 0x0d:		// AD
-			UML_CMP(block, condtemp ? mem(&m_core->condtemp) : FLAGS_AD, 0);
-			UML_JMPc(block, n ? COND_NE : COND_E, skip_label);
-			break;
+		case 0x00:	flag = ST_MN; break;
+		case 0x01:	flag = ST_MZ; break;
+		case 0x02:	flag = ST_MV; break;
+		case 0x03:	flag = ST_MU; break;
+		case 0x04:	flag = ST_ZD; break;
+		case 0x05:	flag = ST_NR; break;
+		case 0x06:	flag = ST_IL; break;
+		case 0x07:	flag = ST_ZC; break;
+		case 0x08:	flag = ST_AN; break;
+		case 0x09:	flag = ST_AZ; break;
+		case 0x0a:	flag = ST_AV; break;
+		case 0x0b:	flag = ST_AU; break;
+		case 0x0c:	flag = ST_MD; break;
+		case 0x0d:	flag = ST_AD; break;
 		default:
 			fatalerror("generate_condition: unimplemented cc %02X at %08X", cc, desc->pc);
-			break;
+			return;
 	}
+
+	if (!condtemp)
+		generate_materialize_flags(block, compiler, (flag & (ST_MN | ST_MZ)) != 0, flag & (ST_AN | ST_AZ | ST_MN | ST_MZ));
+
+	UML_TEST(block, condtemp ? mem(&m_core->condtemp) : FLAGS_ST, flag);
+	UML_JMPc(block, n ? COND_NZ : COND_Z, skip_label);
 }
 
 
@@ -1542,15 +2733,15 @@ void mb86235_device::generate_control(drcuml_block *block, compiler_state *compi
 				UML_MOV(block, mem(&m_core->rpc), AR(ef2 >> 13));		// ARx
 			else
 				UML_MOV(block, mem(&m_core->rpc), ef2);					// immediate
-			UML_MOV(block, FLAGS_RP, 1);
+			UML_OR(block, FLAGS_ST, FLAGS_ST, ST_RP);
 			break;
 
 		case 0x02:		// SETL
 			if (ef1 != 0)
-				UML_MOV(block, mem(&m_core->lpc), AR(ef2 >> 13));		// ARx
+				UML_MOV(block, LPC, AR(ef2 >> 13));		// ARx
 			else
-				UML_MOV(block, mem(&m_core->lpc), ef2);					// immediate
-			UML_MOV(block, FLAGS_LP, 1);
+				UML_MOV(block, LPC, ef2);				// immediate
+			UML_OR(block, FLAGS_ST, FLAGS_ST, ST_LP);
 			break;
 
 		case 0x03:		// 
@@ -1602,19 +2793,33 @@ void mb86235_device::generate_control(drcuml_block *block, compiler_state *compi
 			break;
 		}
 
-		case 0x1a:		// DCALL
+		case 0x18:		// DCcc
 		{
-			// push PC
-			code_label no_overflow = compiler->labelnum++;
-			UML_CMP(block, mem(&m_core->pcs_ptr), 4);
-			UML_JMPc(block, COND_L, no_overflow);
-			UML_MOV(block, mem(&m_core->pc), desc->pc);
-			UML_CALLC(block, cfunc_pcs_overflow, this);
+			code_label skip_label = compiler->labelnum++;
+
+			generate_branch_target(block, compiler, desc, (op >> 12) & 0xf, ef2);
+			generate_condition(block, compiler, desc, ef1, false, skip_label, true);
+			generate_push_pc(block, compiler, desc);
+			generate_branch(block, compiler, desc);
+			UML_LABEL(block, skip_label);
+			break;
+		}
+
+		case 0x19:		// DCNcc
+		{
+			code_label skip_label = compiler->labelnum++;
+
+			generate_branch_target(block, compiler, desc, (op >> 12) & 0xf, ef2);
+			generate_condition(block, compiler, desc, ef1, true, skip_label, true);
+			generate_push_pc(block, compiler, desc);
+			generate_branch(block, compiler, desc);
+			UML_LABEL(block, skip_label);
+			break;
+		}
 
-			UML_LABEL(block, no_overflow);
-			UML_STORE(block, m_core->pcs, mem(&m_core->pcs_ptr), desc->pc + 2, SIZE_DWORD, SCALE_x4);
-			UML_ADD(block, mem(&m_core->pcs_ptr), mem(&m_core->pcs_ptr), 1);
-			
+		case 0x1a:		// DCALL
+		{
+			generate_push_pc(block, compiler, desc);
 			generate_branch_target(block, compiler, desc, (op >> 12) & 0xf, ef2);
 			generate_branch(block, compiler, desc);
 			break;
@@ -1622,29 +2827,154 @@ void mb86235_device::generate_control(drcuml_block *block, compiler_state *compi
 
 		case 0x1b:		// DRET
 		{
-			// pop PC
-			code_label no_underflow = compiler->labelnum++;
-			UML_CMP(block, mem(&m_core->pcs_ptr), 0);
-			UML_JMPc(block, COND_G, no_underflow);
-			UML_MOV(block, mem(&m_core->pc), desc->pc);
-			UML_CALLC(block, cfunc_pcs_underflow, this);
+			generate_pop_pc(block, compiler, desc);
+			generate_branch(block, compiler, desc);
+			break;
+		}
 
-			UML_LABEL(block, no_underflow);
-			UML_SUB(block, mem(&m_core->pcs_ptr), mem(&m_core->pcs_ptr), 1);
-			UML_LOAD(block, I0, m_core->pcs, mem(&m_core->pcs_ptr), SIZE_DWORD, SCALE_x4);
-			
+		case 0x13:		// DBLP
+		{
+			code_label skip_label = compiler->labelnum++;
+
+			UML_SUB(block, LPC, LPC, 1);
+			UML_CMP(block, LPC, 0);
+			UML_JMPc(block, COND_LE, skip_label);
 			generate_branch(block, compiler, desc);
+			UML_LABEL(block, skip_label);
 			break;
 		}
 
 		default:
 			UML_MOV(block, mem(&m_core->pc), desc->pc);
 			UML_MOV(block, mem(&m_core->arg0), cop);
+			save_fast_iregs(block);
 			UML_CALLC(block, cfunc_unimplemented_control, this);
 			break;
 	}
 }
 
+bool mb86235_device::external_xfer_info(const opcode_desc *desc, int *dir, int32_t *disp)
+{
+	// checks for a MOV1 or MOV2 between a register and E(@EB+EO++disp)
+	// MOV1 to or from the internal RAM is left out, RAM-A shares the data space with the
+	// external memory. So is a load of EB or EO, which moves the words after it.
+	uint64_t opcode = desc->opptr.q[0];
+	int reg;
+
+	switch ((opcode >> 61) & 7)
+	{
+		case 1:		// MOV1
+			if (((opcode >> 26) & 1) == 0 || ((opcode >> 12) & 0x40) != 0)
+				return false;
+			reg = (opcode >> 12) & 0x3f;
+			*dir = (opcode >> 25) & 1;
+			*disp = (opcode >> 19) & 0x7f;
+			if (*disp & 0x40) *disp |= 0xffffff80;
+			break;
+
+		case 5:		// MOV2
+			if (((opcode >> 39) & 3) != 0 || ((opcode >> 38) & 1) == 0)
+				return false;
+			reg = (opcode >> 24) & 0x3f;
+			*dir = (opcode >> 37) & 1;
+			*disp = (opcode >> 7) & 0x3fff;
+			if (*disp & 0x2000) *disp |= 0xffffc000;
+			break;
+
+		default:
+			return false;
+	}
+
+	if (*dir == 1 && reg >= 0x10 && reg <= 0x13)		// EB, EBU, EBL, EO
+		return false;
+	return true;
+}
+
+int mb86235_device::external_burst_length(const opcode_desc *desc)
+{
+	// Consecutive external transfers in the same direction and with the same EO step are done
+	// as one burst. Nothing in the middle of a burst may leave the block, so the transfers after
+	// the first can't be branch targets or use the FIFOs.
+	int dir, nextdir;
+	int32_t disp, nextdisp;
+
+	if (DISABLE_EXTERNAL_BURST || (machine().debug_flags & DEBUG_FLAG_ENABLED) != 0 ||
+		(desc->flags & OPFLAG_IN_DELAY_SLOT) || (desc->userflags & OP_USERFLAG_REPEATED_OP) ||
+		!external_xfer_info(desc, &dir, &disp))
+		return 1;
+
+	int count = 1;
+	while (count < int(ARRAY_LENGTH(m_core->burst)) && !(desc->flags & OPFLAG_END_SEQUENCE))
+	{
+		desc = desc->next();
+		if (desc == nullptr || (desc->flags & (OPFLAG_IS_BRANCH_TARGET | OPFLAG_VIRTUAL_NOOP | OPFLAG_COMPILER_UNMAPPED)) ||
+			(desc->userflags & (OP_USERFLAG_FIFOIN | OP_USERFLAG_FIFOOUT0 | OP_USERFLAG_FIFOOUT1 | OP_USERFLAG_REPEATED_OP)) ||
+			!external_xfer_info(desc, &nextdir, &nextdisp) || nextdir != dir || nextdisp != disp)
+			break;
+		count++;
+	}
+	return count;
+}
+
+void mb86235_device::generate_external_xfer(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int dir, int32_t disp)
+{
+	// Moves I1 to (dir 0) or from (dir 1) E(@EB+EO+disp), then steps EO by disp
+	if (compiler->burst_count == 0)
+	{
+		compiler->burst_count = external_burst_length(desc);
+		compiler->burst_index = 0;
+	}
+
+	if (compiler->burst_count == 1)
+	{
+		UML_ADD(block, I0, mem(&m_core->eb), mem(&m_core->eo));                             // add     i0,[eb],[eo]
+		UML_ADD(block, I0, I0, disp);                                                       // add     i0,i0,disp
+		UML_SHL(block, I0, I0, 2);                                                          // shl     i0,i0,2
+		if (dir == 0)
+			UML_WRITE(block, I0, I1, SIZE_DWORD, SPACE_DATA);                               // write   i0,i1,dword,data
+		else
+			UML_READ(block, I1, I0, SIZE_DWORD, SPACE_DATA);                                // read    i1,i0,dword,data
+		UML_ADD(block, mem(&m_core->eo), mem(&m_core->eo), disp);                           // add     [eo],[eo],disp
+		compiler->burst_count = 0;
+		return;
+	}
+
+	// in a burst the first read fetches every word, and the last write stores them all
+	int index = compiler->burst_index++;
+	int count = compiler->burst_count;
+
+	if (dir == 1)
+	{
+		if (index == 0)
+		{
+			UML_ADD(block, I0, mem(&m_core->eb), mem(&m_core->eo));                         // add     i0,[eb],[eo]
+			UML_ADD(block, mem(&m_core->arg0), I0, disp);                                   // add     [arg0],i0,disp
+			UML_MOV(block, mem(&m_core->arg1), count);                                      // mov     [arg1],count
+			UML_MOV(block, mem(&m_core->arg2), disp);                                       // mov     [arg2],disp
+			UML_CALLC(block, cfunc_external_burst_read, this);                              // callc   external_burst_read
+		}
+		UML_MOV(block, I1, mem(&m_core->burst[index]));                                     // mov     i1,[burst + index]
+	}
+	else
+		UML_MOV(block, mem(&m_core->burst[index]), I1);                                     // mov     [burst + index],i1
+
+	UML_ADD(block, mem(&m_core->eo), mem(&m_core->eo), disp);                               // add     [eo],[eo],disp
+
+	if (index == count - 1)
+	{
+		if (dir == 0)
+		{
+			// EO has stepped past every word of the burst by now
+			UML_ADD(block, I0, mem(&m_core->eb), mem(&m_core->eo));                         // add     i0,[eb],[eo]
+			UML_SUB(block, mem(&m_core->arg0), I0, (count - 1) * disp);                     // sub     [arg0],i0,(count - 1) * disp
+			UML_MOV(block, mem(&m_core->arg1), count);                                      // mov     [arg1],count
+			UML_MOV(block, mem(&m_core->arg2), disp);                                       // mov     [arg2],disp
+			UML_CALLC(block, cfunc_external_burst_write, this);                             // callc   external_burst_write
+		}
+		compiler->burst_count = 0;
+	}
+}
+
 void mb86235_device::generate_xfer1(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc)
 {
 	uint64_t opcode = desc->opptr.q[0];
@@ -1655,7 +2985,7 @@ void mb86235_device::generate_xfer1(drcuml_block *block, compiler_state *compile
 	int ary = (opcode >> 4) & 7;
 	int disp5 = (opcode >> 7) & 0x1f;
 	int trm = (opcode >> 26) & 1;
-//	int dir = (opcode >> 25) & 1;
+	int dir = (opcode >> 25) & 1;
 
 	if (trm == 0)
 	{
@@ -1673,16 +3003,7 @@ void mb86235_device::generate_xfer1(drcuml_block *block, compiler_state *compile
 			else
 			{
 				generate_ea(block, compiler, desc, md, sr & 7, ary, disp5);
-				if (sr & 0x20)	// RAM-B
-				{
-					UML_SHL(block, I0, I0, 2);
-					UML_READ(block, I1, I0, SIZE_DWORD, SPACE_IO);
-				}
-				else // RAM-A
-				{
-					UML_SHL(block, I0, I0, 2);
-					UML_READ(block, I1, I0, SIZE_DWORD, SPACE_DATA);
-				}
+				generate_ram_read(block, compiler, (sr >> 5) & 1);
 			}
 
 			if ((dr & 0x40) == 0)
@@ -1692,30 +3013,106 @@ void mb86235_device::generate_xfer1(drcuml_block *block, compiler_state *compile
 			else
 			{
 				generate_ea(block, compiler, desc, md, dr & 7, ary, disp5);
-				if (dr & 0x20)	// RAM-B
-				{
-					UML_SHL(block, I0, I0, 2);
-					UML_WRITE(block, I0, I1, SIZE_DWORD, SPACE_IO);
-				}
-				else // RAM-A
-				{
-					UML_SHL(block, I0, I0, 2);
-					UML_WRITE(block, I0, I1, SIZE_DWORD, SPACE_DATA);
-				}
+				generate_ram_write(block, compiler, (dr >> 5) & 1, I1);
 			}
 		}
 	}
 	else
 	{
 		// external transfer
-		fatalerror("generate_xfer1 MOV1 at %08X (%08X%08X)", desc->pc, (uint32_t)(opcode >> 32), (uint32_t)(opcode));
+		int32_t disp7 = sr;
+		if (disp7 & 0x40) disp7 |= 0xffffff80;
+
+		if (dir == 0)
+		{
+			if ((dr & 0x40) == 0)
+			{
+				generate_reg_read(block, compiler, desc, dr & 0x3f, I1);
+			}
+			else
+			{
+				generate_ea(block, compiler, desc, md, dr & 7, ary, disp5);
+				generate_ram_read(block, compiler, (dr >> 5) & 1);
+			}
+			generate_external_xfer(block, compiler, desc, 0, disp7);
+		}
+		else
+		{
+			generate_external_xfer(block, compiler, desc, 1, disp7);
+			if ((dr & 0x40) == 0)
+			{
+				generate_reg_write(block, compiler, desc, dr & 0x3f, I1);
+			}
+			else
+			{
+				generate_ea(block, compiler, desc, md, dr & 7, ary, disp5);
+				generate_ram_write(block, compiler, (dr >> 5) & 1, I1);
+			}
+		}
+	}
+}
+
+void mb86235_device::generate_double_xfer_source(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int sd, int reg, int md, int arx, int ary, int bank)
+{
+	// reads the source of one half of a double transfer into I1
+	if (sd == 2)	// RAM -> reg
+	{
+		generate_ea(block, compiler, desc, md, arx, ary, 0);
+		generate_ram_read(block, compiler, bank);
+	}
+	else
+		generate_reg_read(block, compiler, desc, reg, I1);
+}
+
+void mb86235_device::generate_double_xfer_dest(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc, int sd, int reg, int md, int arx, int ary, int bank, uml::parameter src)
+{
+	// writes src to the destination of one half of a double transfer
+	if (sd == 1)	// reg -> RAM
+	{
+		generate_ea(block, compiler, desc, md, arx, ary, 0);
+		generate_ram_write(block, compiler, bank, src);
 	}
+	else
+		generate_reg_write(block, compiler, desc, reg, src);
 }
 
 void mb86235_device::generate_double_xfer1(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc)
 {
+	uint64_t opcode = desc->opptr.q[0];
+
+	int sd = (opcode >> 25) & 3;
+	int md = opcode & 0xf;
+
+	// both buses move at once, so both sources are read before either destination is written;
+	// the RAM accessors only use I0 and I1, the A side waits in I2
+	if (sd == 0)
+	{
+		generate_reg_read(block, compiler, desc, (opcode >> 20) & 0x1f, I2);
+		generate_reg_read(block, compiler, desc, (opcode >> 10) & 0x1f, I1);
+		generate_reg_write(block, compiler, desc, (opcode >> 5) & 0x1f, I1);
+		generate_reg_write(block, compiler, desc, (opcode >> 15) & 0x1f, I2);
+		return;
+	}
+	else if (sd != 3)
+	{
+		int areg = (opcode >> 20) & 0x1f;
+		int aarx = (opcode >> 17) & 7;
+		int aary = (opcode >> 14) & 7;
+		int breg = (opcode >> 10) & 0xf;
+		int barx = (opcode >> 7) & 7;
+		int bary = (opcode >> 4) & 7;
+
+		generate_double_xfer_source(block, compiler, desc, sd, areg, md, aarx, aary, 0);
+		UML_MOV(block, I2, I1);                                                             // mov     i2,i1
+		generate_double_xfer_source(block, compiler, desc, sd, breg, md, barx, bary, 1);
+		generate_double_xfer_dest(block, compiler, desc, sd, breg, md, barx, bary, 1, I1);
+		generate_double_xfer_dest(block, compiler, desc, sd, areg, md, aarx, aary, 0, I2);
+		return;
+	}
+
 	UML_MOV(block, mem(&m_core->pc), desc->pc);
 	UML_DMOV(block, mem(&m_core->arg64), desc->opptr.q[0]);
+	save_fast_iregs(block);
 	UML_CALLC(block, cfunc_unimplemented_double_xfer1, this);
 }
 
@@ -1752,16 +3149,7 @@ void mb86235_device::generate_xfer2(drcuml_block *block, compiler_state *compile
 				else
 				{
 					generate_ea(block, compiler, desc, md, sr & 7, ary, disp14);
-					if (sr & 0x20)	// RAM-B
-					{
-						UML_SHL(block, I0, I0, 2);
-						UML_READ(block, I1, I0, SIZE_DWORD, SPACE_IO);
-					}
-					else // RAM-A
-					{
-						UML_SHL(block, I0, I0, 2);
-						UML_READ(block, I1, I0, SIZE_DWORD, SPACE_DATA);
-					}					
+					generate_ram_read(block, compiler, (sr >> 5) & 1);
 				}
 
 				if ((dr & 0x40) == 0)
@@ -1771,16 +3159,7 @@ void mb86235_device::generate_xfer2(drcuml_block *block, compiler_state *compile
 				else
 				{
 					generate_ea(block, compiler, desc, md, dr & 7, ary, disp14);
-					if (dr & 0x20)	// RAM-B
-					{
-						UML_SHL(block, I0, I0, 2);
-						UML_WRITE(block, I0, I1, SIZE_DWORD, SPACE_IO);
-					}
-					else // RAM-A
-					{
-						UML_SHL(block, I0, I0, 2);
-						UML_WRITE(block, I0, I1, SIZE_DWORD, SPACE_DATA);
-					}
+					generate_ram_write(block, compiler, (dr >> 5) & 1, I1);
 				}
 			}
 		}
@@ -1789,35 +3168,95 @@ void mb86235_device::generate_xfer2(drcuml_block *block, compiler_state *compile
 			// external transfer
 			if (dir == 0)
 			{
-				generate_reg_read(block, compiler, desc, dr & 0x3f, I0);
-				UML_ADD(block, I1, mem(&m_core->eb), mem(&m_core->eo));
-				UML_ADD(block, I1, I1, disp14);
-				UML_SHL(block, I1, I1, 2);
-				UML_WRITE(block, I1, I0, SIZE_DWORD, SPACE_DATA);
+				generate_reg_read(block, compiler, desc, dr & 0x3f, I1);
+				generate_external_xfer(block, compiler, desc, 0, disp14);
 			}
 			else
 			{
-				UML_ADD(block, I1, mem(&m_core->eb), mem(&m_core->eo));
-				UML_ADD(block, I1, I1, disp14);
-				UML_SHL(block, I1, I1, 2);
-				UML_READ(block, I0, I1, SIZE_DWORD, SPACE_DATA);
-				generate_reg_write(block, compiler, desc, dr & 0x3f, I0);
+				generate_external_xfer(block, compiler, desc, 1, disp14);
+				generate_reg_write(block, compiler, desc, dr & 0x3f, I1);
 			}
-
-			// update EO
-			UML_ADD(block, mem(&m_core->eo), mem(&m_core->eo), disp14);
 		}
 	}
 	else if (op == 2)	// MOV4
 	{
-		fatalerror("generate_xfer2 MOV4 at %08X (%08X%08X)", desc->pc, (uint32_t)(opcode >> 32), (uint32_t)(opcode));
+		uml::parameter icdtr = mem(&m_core->icdtr[dr & 7]);
+
+		if (trm == 0)
+		{
+			if (sr == 0x58)
+			{
+				// MOV4 #imm24, ICDTRn
+				UML_MOV(block, icdtr, opcode & 0xffffff);
+			}
+			else
+			{
+				if ((sr & 0x40) == 0)
+				{
+					generate_reg_read(block, compiler, desc, sr & 0x3f, I1);
+				}
+				else
+				{
+					generate_ea(block, compiler, desc, md, sr & 7, ary, disp14);
+					generate_ram_read(block, compiler, (sr >> 5) & 1);
+				}
+				UML_MOV(block, icdtr, I1);
+			}
+		}
+		else
+		{
+			// external transfer
+			if (dir == 0)
+			{
+				UML_MOV(block, I1, icdtr);
+				generate_external_xfer(block, compiler, desc, 0, disp14);
+			}
+			else
+			{
+				generate_external_xfer(block, compiler, desc, 1, disp14);
+				UML_MOV(block, icdtr, I1);
+			}
+		}
 	}
 }
 
 void mb86235_device::generate_double_xfer2(drcuml_block *block, compiler_state *compiler, const opcode_desc *desc)
 {
+	uint64_t opcode = desc->opptr.q[0];
+
+	int asd = (opcode >> 38) & 3;
+	int bsd = (opcode >> 18) & 3;
+
+	// each bus has its own field (ICDTR), the displacement isn't used
+	if (asd != 3)
+	{
+		uint32_t afield = (opcode >> 20) & 0x3ffff;
+		uint32_t bfield = opcode & 0x3ffff;
+
+		int as = (afield >> 13) & 0x1f;
+		int ad = (asd == 0) ? ((afield >> 8) & 0x1f) : as;
+		int amd = afield & 0xf;
+		int aarx = (afield >> 10) & 7;
+		int aary = (afield >> 7) & 7;
+
+		int bs = (bfield >> 13) & 0x1f;
+		int bd = (bsd == 0) ? ((bfield >> 8) & 0x1f) : bs;
+		int bmd = bfield & 0xf;
+		int barx = (bfield >> 10) & 7;
+		int bary = (bfield >> 7) & 7;
+
+		generate_double_xfer_source(block, compiler, desc, asd, as, amd, aarx, aary, 0);
+		UML_MOV(block, I2, I1);                                                             // mov     i2,i1
+		generate_double_xfer_source(block, compiler, desc, bsd, bs, bmd, barx, bary, 1);
+		generate_double_xfer_dest(block, compiler, desc, bsd, bd, bmd, barx, bary, 1, I1);
+		generate_double_xfer_dest(block, compiler, desc, asd, ad, amd, aarx, aary, 0, I2);
+		return;
+	}
+
+	// MOVI
 	UML_MOV(block, mem(&m_core->pc), desc->pc);
 	UML_DMOV(block, mem(&m_core->arg64), desc->opptr.q[0]);
+	save_fast_iregs(block);
 	UML_CALLC(block, cfunc_unimplemented_double_xfer2, this);
 }
 
@@ -1841,15 +3280,9 @@ void mb86235_device::generate_xfer3(drcuml_block *block, compiler_state *compile
 			break;
 
 		case 2:		// RAM-A
-			generate_ea(block, compiler, desc, md, dr & 7, ary, disp);
-			UML_SHL(block, I0, I0, 2);
-			UML_WRITE(block, I0, imm, SIZE_DWORD, SPACE_DATA);
-			break;
-
 		case 3:		// RAM-B
 			generate_ea(block, compiler, desc, md, dr & 7, ary, disp);
-			UML_SHL(block, I0, I0, 2);
-			UML_WRITE(block, I0, imm, SIZE_DWORD, SPACE_IO);
+			generate_ram_write(block, compiler, (dr >> 5) & 1, uml::parameter(imm));
 			break;
 	}
 }
@@ -1868,26 +3301,20 @@ void mb86235_device::generate_pre_control(drcuml_block *block, compiler_state *c
 		case 0x11:		// DBNcc
 		case 0x18:		// DCcc
 		case 0x19:		// DCNcc
+			// bring the tested flag up to date if it was deferred
 			switch (ef1)
 			{
-				case 0x00:	UML_MOV(block, mem(&m_core->condtemp), FLAGS_MN); break;		// MN
-				case 0x01:	UML_MOV(block, mem(&m_core->condtemp), FLAGS_MZ); break;		// MZ					
-				case 0x02:	UML_MOV(block, mem(&m_core->condtemp), FLAGS_MV); break;		// MV					
-				case 0x03:	UML_MOV(block, mem(&m_core->condtemp), FLAGS_MU); break;		// MU
-				case 0x04:	UML_MOV(block, mem(&m_core->condtemp), FLAGS_ZD); break;		// ZD
-				case 0x05:	UML_MOV(block, mem(&m_core->condtemp), FLAGS_NR); break;		// NR
-				case 0x06:	UML_MOV(block, mem(&m_core->condtemp), FLAGS_IL); break;		// IL
-				case 0x07:	UML_MOV(block, mem(&m_core->condtemp), FLAGS_ZC); break;		// ZC					
-				case 0x08:	UML_MOV(block, mem(&m_core->condtemp), FLAGS_AN); break;		// AN					
-				case 0x09:	UML_MOV(block, mem(&m_core->condtemp), FLAGS_AZ); break;		// AZ					
-				case 0x0a:	UML_MOV(block, mem(&m_core->condtemp), FLAGS_AV); break;		// AV					
-				case 0x0b:	UML_MOV(block, mem(&m_core->condtemp), FLAGS_AU); break;		// AU					
-				case 0x0c:	UML_MOV(block, mem(&m_core->condtemp), FLAGS_MD); break;		// MD					
-				case 0x0d:	UML_MOV(block, mem(&m_core->condtemp), FLAGS_AD); break;		// AD					
-				default:
-					fatalerror("generate_pre_control: unimplemented cc %02X at %08X", ef1, desc->pc);
-					break;
+				case 0x00:	generate_materialize_flags(block, compiler, true, ST_MN); break;		// MN
+				case 0x01:	generate_materialize_flags(block, compiler, true, ST_MZ); break;		// MZ
+				case 0x08:	generate_materialize_flags(block, compiler, false, ST_AN); break;		// AN
+				case 0x09:	generate_materialize_flags(block, compiler, false, ST_AZ); break;		// AZ
 			}
+
+			// all flag conditions are in ST, so snapshot it before the parallel ALU/MUL updates it
+			if (ef1 <= 0x0d)
+				UML_MOV(block, mem(&m_core->condtemp), FLAGS_ST);
+			else
+				fatalerror("generate_pre_control: unimplemented cc %02X at %08X", ef1, desc->pc);
 			break;
 
 		case 0x14:		// DBBC ARx:y, rel12
@@ -51,10 +51,18 @@
 #define MD_USED(desc)				do { (desc).regin[1] |= 1 << 13; } while (0)
 #define MD_MODIFIED(desc)			do { (desc).regout[1] |= 1 << 13; } while (0)
 
+#define ALL_FLAGS					0x3fff
+
+// how many instructions a liveness scan may look at before giving up
+#define FLAG_LIVENESS_BUDGET		64
+#define FLAG_LIVENESS_BUDGET_HOT	1024
+
 
 mb86235_frontend::mb86235_frontend(mb86235_device *core, uint32_t window_start, uint32_t window_end, uint32_t max_sequence)
 	: drc_frontend(*core, window_start, window_end, max_sequence),
-	m_core(core)
+	m_core(core),
+	m_liveness_budget(FLAG_LIVENESS_BUDGET),
+	m_liveness_tier(0)
 {
 }
 
@@ -250,7 +258,6 @@ void mb86235_frontend::describe_reg_read(opcode_desc &desc, int reg)
 
 		case 0x31:		// FI
 			desc.userflags |= OP_USERFLAG_FIFOIN;
-			desc.flags |= OPFLAG_IS_BRANCH_TARGET;		// fifo check makes this a branch target
 			break;
 
 		case 0x32:		// FO0
@@ -262,7 +269,6 @@ void mb86235_frontend::describe_reg_read(opcode_desc &desc, int reg)
 		case 0x11:		// EBU
 		case 0x12:		// EBL
 		case 0x13:		// EO
-		case 0x15:		// ST
 		case 0x16:		// MOD
 		case 0x17:		// LRPC		
 		case 0x34:		// PDR
@@ -271,6 +277,10 @@ void mb86235_frontend::describe_reg_read(opcode_desc &desc, int reg)
 		case 0x37:		// PWP
 			break;
 
+		case 0x15:		// ST
+			desc.regin[1] |= 0x3fff;		// all flags
+			break;
+
 		case 0x30:		// PR
 			if ((desc.userflags & OP_USERFLAG_PR_MASK) == 0)		// ALU and MUL PR updates have higher priority
 			{
@@ -310,18 +320,15 @@ void mb86235_frontend::describe_reg_write(opcode_desc &desc, int reg)
 
 		case 0x32:		// FO0
 			desc.userflags |= OP_USERFLAG_FIFOOUT0;
-			desc.flags |= OPFLAG_IS_BRANCH_TARGET;		// fifo check makes this a branch target
 			break;
 		case 0x33:		// FO1
 			desc.userflags |= OP_USERFLAG_FIFOOUT1;
-			desc.flags |= OPFLAG_IS_BRANCH_TARGET;		// fifo check makes this a branch target
 			break;
 
 		case 0x10:		// EB
 		case 0x11:		// EBU
 		case 0x12:		// EBL
 		case 0x13:		// EO
-		case 0x15:		// ST
 		case 0x16:		// MOD
 		case 0x17:		// LRPC		
 		case 0x34:		// PDR
@@ -330,6 +337,10 @@ void mb86235_frontend::describe_reg_write(opcode_desc &desc, int reg)
 		case 0x37:		// PWP
 			break;
 
+		case 0x15:		// ST
+			desc.regout[1] |= 0x3fff;		// all flags
+			break;
+
 		case 0x30:		// PR
 			desc.userflags &= ~OP_USERFLAG_PW_MASK;
 			desc.userflags |= OP_USERFLAG_PW_INC;
@@ -449,6 +460,7 @@ void mb86235_frontend::describe_alu(opcode_desc &desc, uint32_t aluop)
 			describe_alu_input(desc, i1); describe_alumul_output(desc, io);
 			AN_MODIFIED(desc);
 			AZ_MODIFIED(desc);
+			AV_USED(desc);			// AV is only ever set, so it carries the earlier value
 			AV_MODIFIED(desc);
 			AD_MODIFIED(desc);
 			break;
@@ -464,6 +476,7 @@ void mb86235_frontend::describe_alu(opcode_desc &desc, uint32_t aluop)
 			describe_alu_input(desc, i1); describe_alu_input(desc, i2); describe_alumul_output(desc, io);
 			AN_MODIFIED(desc);
 			AZ_MODIFIED(desc);
+			AV_USED(desc);
 			AV_MODIFIED(desc);
 			break;
 		case 0x11:		// ADDZ
@@ -477,6 +490,7 @@ void mb86235_frontend::describe_alu(opcode_desc &desc, uint32_t aluop)
 			describe_alu_input(desc, i1); describe_alu_input(desc, i2); describe_alumul_output(desc, io);
 			AN_MODIFIED(desc);
 			AZ_MODIFIED(desc);
+			AV_USED(desc);
 			AV_MODIFIED(desc);
 			break;
 		case 0x13:		// SUBZ
@@ -490,6 +504,7 @@ void mb86235_frontend::describe_alu(opcode_desc &desc, uint32_t aluop)
 			describe_alu_input(desc, i1); describe_alu_input(desc, i2);
 			AN_MODIFIED(desc);
 			AZ_MODIFIED(desc);
+			AV_USED(desc);
 			AV_MODIFIED(desc);
 			break;
 		case 0x15:		// ABS
@@ -585,6 +600,7 @@ void mb86235_frontend::describe_mul(opcode_desc &desc, uint32_t mulop)
 		// MUL
 		MN_MODIFIED(desc);
 		MZ_MODIFIED(desc);
+		MV_USED(desc);			// MV is only ever set, so it carries the earlier value
 		MV_MODIFIED(desc);
 	}
 }
@@ -683,8 +699,13 @@ void mb86235_frontend::describe_xfer1(opcode_desc &desc)
 	}
 	else
 	{
-		// external transfer
-		if (dir == 0)
+		// external transfer, to or from a register or the internal RAM
+		if ((dr & 0x40) != 0)
+		{
+			describe_ea(desc, md, dr & 7, ary, disp5);
+			desc.flags |= OPFLAG_READS_MEMORY | OPFLAG_WRITES_MEMORY;
+		}
+		else if (dir == 0)
 		{
 			describe_reg_read(desc, dr & 0x3f);
 			desc.flags |= OPFLAG_WRITES_MEMORY;
@@ -697,11 +718,46 @@ void mb86235_frontend::describe_xfer1(opcode_desc &desc)
 	}
 }
 
+void mb86235_frontend::describe_double_xfer_field(opcode_desc &desc, int sd, int sreg, int dreg, int md, int arx, int ary)
+{
+	switch (sd)
+	{
+		case 0:		// reg -> reg
+			describe_reg_read(desc, sreg);
+			describe_reg_write(desc, dreg);
+			break;
+		case 1:		// reg -> RAM
+			describe_reg_read(desc, sreg);
+			describe_ea(desc, md, arx, ary, 0);
+			desc.flags |= OPFLAG_WRITES_MEMORY;
+			break;
+		case 2:		// RAM -> reg
+			describe_ea(desc, md, arx, ary, 0);
+			describe_reg_write(desc, dreg);
+			desc.flags |= OPFLAG_READS_MEMORY;
+			break;
+	}
+}
+
 void mb86235_frontend::describe_double_xfer1(opcode_desc &desc)
 {
 	uint64_t opcode = desc.opptr.q[0];
 
-	fatalerror("mb86235_frontend: describe_double_xfer1 at %08X (%08X%08X)", desc.pc, (uint32_t)(opcode >> 32), (uint32_t)(opcode));
+	int sd = (opcode >> 25) & 3;
+	int md = opcode & 0xf;
+
+	if (sd == 0)
+	{
+		describe_double_xfer_field(desc, 0, (opcode >> 20) & 0x1f, (opcode >> 15) & 0x1f, 0, 0, 0);
+		describe_double_xfer_field(desc, 0, (opcode >> 10) & 0x1f, (opcode >> 5) & 0x1f, 0, 0, 0);
+	}
+	else
+	{
+		int areg = (opcode >> 20) & 0x1f;
+		int breg = (opcode >> 10) & 0xf;
+		describe_double_xfer_field(desc, sd, areg, areg, md, (opcode >> 17) & 7, (opcode >> 14) & 7);
+		describe_double_xfer_field(desc, sd, breg, breg, md, (opcode >> 7) & 7, (opcode >> 4) & 7);
+	}
 }
 
 void mb86235_frontend::describe_xfer2(opcode_desc &desc)
@@ -762,7 +818,23 @@ void mb86235_frontend::describe_xfer2(opcode_desc &desc)
 	}
 	else if (op == 2)	// MOV4
 	{
-		fatalerror("mb86235_frontend: describe_xfer2 MOV4 at %08X (%08X%08X)", desc.pc, (uint32_t)(opcode >> 32), (uint32_t)(opcode));
+		if (trm == 0)
+		{
+			if ((sr & 0x40) == 0)
+			{
+				describe_reg_read(desc, sr & 0x3f);
+			}
+			else if (sr != 0x58)
+			{
+				describe_ea(desc, md, sr & 7, ary, disp14);
+				desc.flags |= OPFLAG_READS_MEMORY;
+			}
+		}
+		else
+		{
+			// external transfer
+			desc.flags |= (dir == 0) ? OPFLAG_WRITES_MEMORY : OPFLAG_READS_MEMORY;
+		}
 	}
 
 }
@@ -770,7 +842,26 @@ void mb86235_frontend::describe_xfer2(opcode_desc &desc)
 void mb86235_frontend::describe_double_xfer2(opcode_desc &desc)
 {
 	uint64_t opcode = desc.opptr.q[0];
-	fatalerror("mb86235_frontend: describe_double_xfer2 at %08X (%08X%08X)", desc.pc, (uint32_t)(opcode >> 32), (uint32_t)(opcode));
+
+	int asd = (opcode >> 38) & 3;
+	int bsd = (opcode >> 18) & 3;
+
+	if (asd == 3)
+	{
+		// MOVI, not compiled
+		desc.flags |= OPFLAG_READS_MEMORY | OPFLAG_WRITES_MEMORY;
+		return;
+	}
+
+	uint32_t field[2] = { uint32_t(opcode >> 20) & 0x3ffff, uint32_t(opcode) & 0x3ffff };
+	int sd[2] = { asd, bsd };
+	for (int bus = 0; bus < 2; bus++)
+	{
+		if (sd[bus] == 0)
+			describe_double_xfer_field(desc, 0, (field[bus] >> 13) & 0x1f, (field[bus] >> 8) & 0x1f, 0, 0, 0);
+		else
+			describe_double_xfer_field(desc, sd[bus], (field[bus] >> 13) & 0x1f, (field[bus] >> 13) & 0x1f, field[bus] & 0xf, (field[bus] >> 10) & 7, (field[bus] >> 7) & 7);
+	}
 }
 
 void mb86235_frontend::describe_xfer3(opcode_desc &desc)
@@ -817,8 +908,11 @@ void mb86235_frontend::describe_control(opcode_desc &desc)
 		case 0x02:		// SETL
 			if (ef1 != 0)	// ARx
 				AR_USED(desc, (ef2 >> 13) & 7);
+
+			desc.userflags |= OP_USERFLAG_LPC;
 			break;
 		case 0x03:		// CLRFI/CLRFO/CLRF
+			desc.userflags |= OP_USERFLAG_FIFO_CLEAR;
 			break;
 		case 0x04:		// PUSH
 			describe_reg_read(desc, (ef2 >> 6) & 0x3f);
@@ -842,6 +936,7 @@ void mb86235_frontend::describe_control(opcode_desc &desc)
 			desc.flags |= OPFLAG_IS_CONDITIONAL_BRANCH;
 			desc.targetpc = desc.pc + rel12;
 			desc.delayslots = 1;
+			desc.userflags |= OP_USERFLAG_LPC;
 			break;
 		case 0x14:		// DBBC ARx:y, rel12
 			desc.flags |= OPFLAG_IS_CONDITIONAL_BRANCH;
@@ -886,6 +981,7 @@ void mb86235_frontend::describe_control(opcode_desc &desc)
 				case 0xf: desc.targetpc = BRANCH_TARGET_DYNAMIC; describe_reg_read(desc, (ef2 >> 6) & 0x3f); break;
 			}
 
+			describe_condition(desc, ef1);
 			desc.flags |= OPFLAG_IS_CONDITIONAL_BRANCH;
 			desc.delayslots = 1;
 			break;
@@ -919,4 +1015,203 @@ void mb86235_frontend::describe_control(opcode_desc &desc)
 			break;
 		}
 	}
-}
\ No newline at end of file
+}
+
+void mb86235_frontend::describe_condition(opcode_desc &desc, int cc)
+{
+	switch (cc)
+	{
+		case 0x00:	MN_USED(desc); break;
+		case 0x01:	MZ_USED(desc); break;
+		case 0x02:	MV_USED(desc); break;
+		case 0x03:	MU_USED(desc); break;
+		case 0x04:	ZD_USED(desc); break;
+		case 0x05:	NR_USED(desc); break;
+		case 0x06:	IL_USED(desc); break;
+		case 0x07:	ZC_USED(desc); break;
+		case 0x08:	AN_USED(desc); break;
+		case 0x09:	AZ_USED(desc); break;
+		case 0x0a:	AV_USED(desc); break;
+		case 0x0b:	AU_USED(desc); break;
+		case 0x0c:	MD_USED(desc); break;
+		case 0x0d:	AD_USED(desc); break;
+		default:	desc.regin[1] |= ALL_FLAGS; break;
+	}
+}
+
+void mb86235_frontend::describe_single(opcode_desc &desc, uint32_t pc, const opcode_desc *prev)
+{
+	// describes one instruction outside of describe_code, for the liveness scan and the interpreter
+	desc.pc = pc;
+	desc.physpc = pc;
+	desc.targetpc = BRANCH_TARGET_DYNAMIC;
+	desc.flags = 0;
+	desc.userflags = 0;
+	desc.delayslots = 0;
+	desc.skipslots = 0;
+	memset(desc.regin, 0, sizeof(desc.regin));
+	memset(desc.regout, 0, sizeof(desc.regout));
+	memset(desc.regreq, 0, sizeof(desc.regreq));
+
+	if (!describe(desc, prev))
+		desc.flags |= OPFLAG_INVALID_OPCODE;
+}
+
+bool mb86235_frontend::describe_instruction(opcode_desc &desc, uint32_t pc)
+{
+	// describes one instruction for the interpreter, looking at the one before it
+	// so that an op following REP is flagged as repeated like in a sequence
+	opcode_desc prev;
+	if (pc > 0)
+	{
+		describe_single(prev, pc - 1);
+		describe_single(desc, pc, &prev);
+	}
+	else
+		describe_single(desc, pc);
+
+	return !(desc.flags & OPFLAG_INVALID_OPCODE);
+}
+
+uint32_t mb86235_frontend::flags_required(const opcode_desc &desc, bool hot)
+{
+	// Returns the flags written by this instruction that may be read before being written
+	// again. Follows static branch targets and fall-through across sequence and block
+	// boundaries; anything that cannot be followed counts as reading every flag.
+	// Hot blocks can afford a much longer scan, and keep their own results.
+	uint32_t written = desc.regout[1] & ALL_FLAGS;
+	if (written == 0)
+		return 0;
+
+	m_liveness_tier = hot ? 1 : 0;
+	m_liveness_budget = hot ? FLAG_LIVENESS_BUDGET_HOT : FLAG_LIVENESS_BUDGET;
+
+	int budget = m_liveness_budget;
+	std::vector<uint32_t> path;
+	uint32_t live;
+
+	if (desc.flags & OPFLAG_IN_DELAY_SLOT)
+	{
+		// the delay slot copy is only compiled on the taken path of its branch
+		if (desc.branch == nullptr || desc.branch->targetpc == BRANCH_TARGET_DYNAMIC)
+			live = ALL_FLAGS;
+		else
+			live = flags_live_at(desc.branch->targetpc);
+	}
+	else
+		live = scan_flags_live_after(desc, 0, budget, path);
+
+	// a repeated instruction runs again before anything else
+	if (desc.userflags & OP_USERFLAG_REPEATED_OP)
+		live |= desc.regin[1];
+
+	return written & live;
+}
+
+uint32_t mb86235_frontend::flags_live_at(uint32_t pc)
+{
+	auto found = m_flag_liveness[m_liveness_tier].find(pc);
+	if (found != m_flag_liveness[m_liveness_tier].end())
+	{
+		mark_scanned(found->second.pages);
+		return found->second.live;
+	}
+
+	// keep the pages of this scan alone with its result
+	std::vector<uint32_t> outer;
+	outer.swap(m_scanned_pages);
+
+	int budget = m_liveness_budget;
+	std::vector<uint32_t> path;
+	uint32_t live = scan_flags_live(pc, 0, budget, path);
+
+	liveness_entry &entry = m_flag_liveness[m_liveness_tier][pc];
+	entry.live = live;
+	entry.pages = m_scanned_pages;
+	mark_scanned(outer);
+	return live;
+}
+
+void mb86235_frontend::mark_scanned(uint32_t pc)
+{
+	uint32_t page = pc >> CODE_PAGE_SHIFT;
+	if (std::find(m_scanned_pages.begin(), m_scanned_pages.end(), page) == m_scanned_pages.end())
+		m_scanned_pages.push_back(page);
+}
+
+void mb86235_frontend::mark_scanned(const std::vector<uint32_t> &pages)
+{
+	for (uint32_t page : pages)
+		mark_scanned(page << CODE_PAGE_SHIFT);
+}
+
+uint32_t mb86235_frontend::scan_flags_live(uint32_t pc, uint32_t killed, int &budget, std::vector<uint32_t> &path)
+{
+	// Returns the flags not in killed that may be read from pc onwards before being written
+	if ((killed & ALL_FLAGS) == ALL_FLAGS)
+		return 0;
+
+	// a full scan from here is already known, and is a superset of what we would find
+	if (killed == 0)
+	{
+		auto found = m_flag_liveness[m_liveness_tier].find(pc);
+		if (found != m_flag_liveness[m_liveness_tier].end())
+		{
+			mark_scanned(found->second.pages);
+			return found->second.live;
+		}
+	}
+
+	if (budget-- <= 0)
+		return ALL_FLAGS & ~killed;
+
+	// going around a loop again can only find reads we already found the first time
+	if (std::find(path.begin(), path.end(), pc) != path.end())
+		return 0;
+
+	opcode_desc desc;
+	describe_single(desc, pc);
+	mark_scanned(pc);
+	if (desc.flags & OPFLAG_INVALID_OPCODE)
+		return ALL_FLAGS & ~killed;
+
+	uint32_t live = desc.regin[1] & ALL_FLAGS & ~killed;
+	killed |= desc.regout[1];
+
+	path.push_back(pc);
+	live |= scan_flags_live_after(desc, killed, budget, path);
+	path.pop_back();
+
+	return live;
+}
+
+uint32_t mb86235_frontend::scan_flags_live_after(const opcode_desc &desc, uint32_t killed, int &budget, std::vector<uint32_t> &path)
+{
+	// Returns the flags not in killed that may be read after desc has executed
+	uint32_t live = 0;
+
+	if (!(desc.flags & (OPFLAG_IS_CONDITIONAL_BRANCH | OPFLAG_IS_UNCONDITIONAL_BRANCH)))
+		return scan_flags_live(desc.pc + 1, killed, budget, path);
+
+	// the delay slot runs on both paths
+	if (desc.delayslots > 0)
+	{
+		opcode_desc delay;
+		describe_single(delay, desc.pc + 1);
+		mark_scanned(desc.pc + 1);
+		if (delay.flags & (OPFLAG_INVALID_OPCODE | OPFLAG_IS_CONDITIONAL_BRANCH | OPFLAG_IS_UNCONDITIONAL_BRANCH))
+			return ALL_FLAGS & ~killed;
+
+		live |= delay.regin[1] & ALL_FLAGS & ~killed;
+		killed |= delay.regout[1];
+	}
+
+	if (desc.targetpc == BRANCH_TARGET_DYNAMIC)
+		return live | (ALL_FLAGS & ~killed);
+
+	live |= scan_flags_live(desc.targetpc, killed, budget, path);
+	if (desc.flags & OPFLAG_IS_CONDITIONAL_BRANCH)
+		live |= scan_flags_live(desc.pc + 1 + desc.delayslots, killed, budget, path);
+
+	return live;
+}
@@ -15,11 +15,19 @@
 #ifndef __MB86235FE_H__
 #define __MB86235FE_H__
 
+// program space is tracked for rewrites in pages of 1 << CODE_PAGE_SHIFT instructions
+#define CODE_PAGE_SHIFT                 8
+
 class mb86235_frontend : public drc_frontend
 {
 public:
 	mb86235_frontend(mb86235_device *core, uint32_t window_start, uint32_t window_end, uint32_t max_sequence);
 
+	uint32_t flags_required(const opcode_desc &desc, bool hot = false);
+	void flush_flag_liveness() { m_flag_liveness[0].clear(); m_flag_liveness[1].clear(); }
+	void take_scanned_pages(std::vector<uint32_t> &pages) { pages.insert(pages.end(), m_scanned_pages.begin(), m_scanned_pages.end()); m_scanned_pages.clear(); }
+	bool describe_instruction(opcode_desc &desc, uint32_t pc);
+
 protected:
 	// required overrides
 	virtual bool describe(opcode_desc &desc, const opcode_desc *prev) override;
@@ -28,6 +36,20 @@ private:
 
 	mb86235_device *m_core;
 
+	// flag liveness at the start of an instruction, by pc, for normal and hot blocks,
+	// with the program pages the scan read to work it out
+	struct liveness_entry
+	{
+		uint32_t live;
+		std::vector<uint32_t> pages;
+	};
+	std::unordered_map<uint32_t, liveness_entry> m_flag_liveness[2];
+	int m_liveness_budget;
+	int m_liveness_tier;
+
+	// program pages read by the scans since the last take_scanned_pages
+	std::vector<uint32_t> m_scanned_pages;
+
 	void describe_alu(opcode_desc &desc, uint32_t aluop);
 	void describe_mul(opcode_desc &desc, uint32_t mulop);
 	void describe_xfer1(opcode_desc &desc);
@@ -42,6 +64,14 @@ private:
 	void describe_reg_read(opcode_desc &desc, int reg);
 	void describe_reg_write(opcode_desc &desc, int reg);
 	void describe_ea(opcode_desc &desc, int md, int arx, int ary, int disp);
+	void describe_double_xfer_field(opcode_desc &desc, int sd, int sreg, int dreg, int md, int arx, int ary);
+	void describe_condition(opcode_desc &desc, int cc);
+	void describe_single(opcode_desc &desc, uint32_t pc, const opcode_desc *prev = nullptr);
+	uint32_t flags_live_at(uint32_t pc);
+	void mark_scanned(uint32_t pc);
+	void mark_scanned(const std::vector<uint32_t> &pages);
+	uint32_t scan_flags_live(uint32_t pc, uint32_t killed, int &budget, std::vector<uint32_t> &path);
+	uint32_t scan_flags_live_after(const opcode_desc &desc, uint32_t killed, int &budget, std::vector<uint32_t> &path);
 };
 
 #endif /* __MB86235FE_H__ */
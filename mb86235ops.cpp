@@ -0,0 +1,1081 @@
+// license:BSD-3-Clause
+// copyright-holders:Ville Linde
+
+/******************************************************************************
+
+    MB86235 interpreter
+
+    Used when the recompiler is disabled. Instructions are described once by
+    the recompiler front-end and kept in a direct-mapped table of decoded ops,
+    so the execution loop only switches on the pre-extracted fields.
+    The semantics follow the UML generators in mb86235drc.cpp.
+
+******************************************************************************/
+
+#include "emu.h"
+#include "debugger.h"
+#include "mb86235.h"
+#include "mb86235fe.h"
+
+
+// number of decoded instructions kept, must be a power of two
+#define DECODE_CACHE_SIZE               0x2000
+
+// decoded_op flags
+#define DECODED_VALID                   0x01
+#define DECODED_ALU                     0x02
+#define DECODED_MUL                     0x04
+#define DECODED_ALUTEMP                 0x08        // ALU result is written after the transfer
+#define DECODED_MULTEMP                 0x10        // MUL result is written after the transfer
+#define DECODED_REPEATED                0x20
+
+
+static inline uint32_t saturate24(uint32_t value, bool &overflow)
+{
+	// clamps to the 24-bit signed range like generate_saturate
+	int32_t v = (int32_t)value;
+	overflow = (v < -0x800000 || v > 0x7fffff);
+	if (v < -0x800000) v = -0x800000;
+	if (v > 0x7fffff) v = 0x7fffff;
+	return (uint32_t)v;
+}
+
+static inline uint32_t int_flags(uint32_t value, uint32_t nflag, uint32_t zflag)
+{
+	return (((int32_t)value < 0) ? nflag : 0) | ((value == 0) ? zflag : 0);
+}
+
+static inline uint32_t float_flags(float value, uint32_t nflag, uint32_t zflag)
+{
+	return ((value < 0.0f) ? nflag : 0) | ((value == 0.0f) ? zflag : 0);
+}
+
+
+void mb86235_device::reset_decode_cache()
+{
+	m_decode.assign(DECODE_CACHE_SIZE, decoded_op());
+}
+
+void mb86235_device::invalidate_decode_cache(offs_t start, offs_t end)
+{
+	for (decoded_op &op : m_decode)
+		if ((op.flags & DECODED_VALID) && op.pc >= start && op.pc <= end)
+			op.flags = 0;
+}
+
+const mb86235_device::decoded_op &mb86235_device::decode_op(uint32_t pc)
+{
+	decoded_op &op = m_decode[pc & (DECODE_CACHE_SIZE - 1)];
+	if ((op.flags & DECODED_VALID) && op.pc == pc)
+		return op;
+
+	// the front-end does the decoding, so the interpreter sees the same flags as the recompiler
+	opcode_desc desc;
+	m_drcfe->describe_instruction(desc, pc);
+
+	uint64_t opcode = desc.opptr.q[0];
+
+	op.opcode = opcode;
+	op.pc = pc;
+	op.targetpc = desc.targetpc;
+	op.userflags = desc.userflags;
+	op.type = (opcode >> 61) & 7;
+	op.flags = DECODED_VALID;
+	op.cycles = desc.cycles;
+	op.aluop = 0;
+	op.mulop = 0;
+
+	switch (op.type)
+	{
+		case 0:		// ALU / MUL / double transfer (type 1)
+		case 1:		// ALU / MUL / transfer (type 1)
+		case 2:		// ALU / MUL / control
+			op.aluop = (opcode >> 42) & 0x7ffff;
+			op.mulop = (opcode >> 27) & 0x7fff;
+			op.flags |= DECODED_ALU | DECODED_MUL;
+			if (op.type != 2)
+			{
+				if (has_register_clash(&desc, (opcode >> 42) & 0x1f) && aluop_has_result((opcode >> 56) & 0x1f))
+					op.flags |= DECODED_ALUTEMP;
+				if (has_register_clash(&desc, (opcode >> 27) & 0x1f))
+					op.flags |= DECODED_MULTEMP;
+			}
+			break;
+
+		case 4:		// ALU or MUL / double transfer (type 2)
+		case 5:		// ALU or MUL / transfer (type 2)
+		case 6:		// ALU or MUL / control
+			if (opcode & ((uint64_t)(1) << 41))
+			{
+				op.aluop = (opcode >> 42) & 0x7ffff;
+				op.flags |= DECODED_ALU;
+				if (op.type != 6 && has_register_clash(&desc, (opcode >> 42) & 0x1f) && aluop_has_result((opcode >> 56) & 0x1f))
+					op.flags |= DECODED_ALUTEMP;
+			}
+			else
+			{
+				op.mulop = (opcode >> 42) & 0x7fff;
+				op.flags |= DECODED_MUL;
+				if (op.type != 6 && has_register_clash(&desc, (opcode >> 42) & 0x1f))
+					op.flags |= DECODED_MULTEMP;
+			}
+			break;
+	}
+
+	if (desc.userflags & OP_USERFLAG_REPEATED_OP)
+		op.flags |= DECODED_REPEATED;
+
+	// FIFO accesses of the delay slot are checked with the branch, as in the recompiler
+	uint32_t fifoflags = desc.userflags;
+	if (desc.delayslots > 0)
+	{
+		opcode_desc delay;
+		m_drcfe->describe_instruction(delay, pc + 1);
+		op.fifoin = ((fifoflags & OP_USERFLAG_FIFOIN) ? 1 : 0) + ((delay.userflags & OP_USERFLAG_FIFOIN) ? 1 : 0);
+		op.fifoout0 = ((fifoflags & OP_USERFLAG_FIFOOUT0) ? 1 : 0) + ((delay.userflags & OP_USERFLAG_FIFOOUT0) ? 1 : 0);
+		op.fifoout1 = ((fifoflags & OP_USERFLAG_FIFOOUT1) ? 1 : 0) + ((delay.userflags & OP_USERFLAG_FIFOOUT1) ? 1 : 0);
+	}
+	else
+	{
+		op.fifoin = (fifoflags & OP_USERFLAG_FIFOIN) ? 1 : 0;
+		op.fifoout0 = (fifoflags & OP_USERFLAG_FIFOOUT0) ? 1 : 0;
+		op.fifoout1 = (fifoflags & OP_USERFLAG_FIFOOUT1) ? 1 : 0;
+	}
+
+	return op;
+}
+
+bool mb86235_device::fifo_ready(const decoded_op &op)
+{
+	if (op.fifoin > 0 && m_core->fifoin.num < op.fifoin)
+		return false;
+	if (op.fifoout0 > 0 && m_core->fifoout0.num >= FIFOOUT0_SIZE - op.fifoout0)
+		return false;
+	if (op.fifoout1 > 0 && m_core->fifoout1.num >= FIFOOUT1_SIZE - op.fifoout1)
+		return false;
+	return true;
+}
+
+
+void mb86235_device::run_interpreter()
+{
+	while (m_core->icount > 0)
+	{
+		const decoded_op &op = decode_op(m_core->pc);
+
+		debugger_instruction_hook(this, m_core->pc);
+
+		// a FIFO stall ends the timeslice, the instruction is retried on the next one
+		if (!fifo_ready(op))
+		{
+			m_core->icount = 0;
+			break;
+		}
+
+		if (op.flags & DECODED_REPEATED)
+		{
+			execute_repeat(op);
+			continue;
+		}
+
+		m_core->icount -= op.cycles;
+		m_core->pc = execute_op(op);
+	}
+}
+
+void mb86235_device::execute_repeat(const decoded_op &op)
+{
+	// runs at least once, then until RPC runs out; the FIFOs are checked before every iteration
+	for (;;)
+	{
+		m_core->icount -= op.cycles;
+		execute_op(op);
+		m_core->rpc--;
+
+		if ((int32_t)m_core->rpc <= 0)
+		{
+			m_core->pc = op.pc + 1;
+			return;
+		}
+
+		// iterations left, resume at the same op on the next timeslice
+		if (m_core->icount <= 0 || !fifo_ready(op))
+		{
+			if (m_core->icount > 0)
+				m_core->icount = 0;
+			return;
+		}
+	}
+}
+
+uint32_t mb86235_device::execute_op(const decoded_op &op)
+{
+	uint32_t nextpc = op.pc + 1;
+	bool taken = false;
+
+	switch (op.type)
+	{
+		case 0:		// ALU / MUL / double transfer (type 1)
+		case 1:		// ALU / MUL / transfer (type 1)
+		case 4:		// ALU or MUL / double transfer (type 2)
+		case 5:		// ALU or MUL / transfer (type 2)
+		{
+			if (op.flags & DECODED_ALU)
+				execute_alu(op, (op.flags & DECODED_ALUTEMP) ? &m_core->alutemp : alu_output(op.aluop & 0x1f));
+			if (op.flags & DECODED_MUL)
+				execute_mul(op, (op.flags & DECODED_MULTEMP) ? &m_core->multemp : alu_output(op.mulop & 0x1f));
+
+			switch (op.type)
+			{
+				case 0:
+					execute_double_xfer1(op);
+					break;
+				case 1:
+					execute_xfer1(op);
+					break;
+				case 4:
+					execute_double_xfer2(op);
+					break;
+				case 5:
+					execute_xfer2(op);
+					break;
+			}
+
+			if (op.flags & DECODED_ALUTEMP)
+				*alu_output(op.aluop & 0x1f) = m_core->alutemp;
+			if (op.flags & DECODED_MULTEMP)
+				*alu_output(op.mulop & 0x1f) = m_core->multemp;
+			break;
+		}
+
+		case 2:		// ALU / MUL / control
+		case 6:		// ALU or MUL / control
+		{
+			// conditions look at the flags from before the parallel ALU/MUL
+			uint32_t condflags = m_core->st;
+
+			if (op.flags & DECODED_ALU)
+				execute_alu(op, alu_output(op.aluop & 0x1f));
+			if (op.flags & DECODED_MUL)
+				execute_mul(op, alu_output(op.mulop & 0x1f));
+
+			taken = execute_control(op, condflags);
+			break;
+		}
+
+		case 7:		// transfer (type 3)
+			execute_xfer3(op);
+			break;
+
+		default:
+			m_core->pc = op.pc;
+			m_core->arg64 = op.opcode;
+			unimplemented_op();
+			break;
+	}
+
+	// update PR and PW if needed
+	if ((op.userflags & OP_USERFLAG_PR_MASK) != 0)
+		step_pr(false, (op.userflags & OP_USERFLAG_PR_MASK) >> 8);
+
+	if ((op.userflags & OP_USERFLAG_PW_MASK) != 0)
+		step_pr(true, (op.userflags & OP_USERFLAG_PW_MASK) >> 10);
+
+	// a taken branch runs its delay slot here, an untaken one runs it as the next instruction
+	if (taken)
+	{
+		const decoded_op &delay = decode_op(op.pc + 1);
+		m_core->icount -= delay.cycles;
+		execute_op(delay);
+		nextpc = m_core->jmpdest;
+	}
+
+	return nextpc;
+}
+
+
+uint32_t mb86235_device::read_fifo_in()
+{
+	if (m_fifo_trace)
+	{
+		m_core->arg0 = m_core->fifoin.rpos;
+		fifoin_trace();
+	}
+
+	uint32_t data = (uint32_t)m_core->fifoin.data[m_core->fifoin.rpos];
+	m_core->fifoin.rpos = (m_core->fifoin.rpos + 1) & (FIFOIN_SIZE - 1);
+	m_core->fifoin.num--;
+	return data;
+}
+
+void mb86235_device::write_fifo_out0(uint32_t data)
+{
+	m_core->fifoout0.data[m_core->fifoout0.wpos] = data;
+	m_core->fifoout0.wpos = (m_core->fifoout0.wpos + 1) & (FIFOOUT0_SIZE - 1);
+	m_core->fifoout0.num++;
+}
+
+void mb86235_device::step_pr(bool pw, int mode)
+{
+	uint32_t &ptr = pw ? m_core->pwp : m_core->prp;
+
+	switch (mode)
+	{
+		case 1:		// ++
+			ptr = (ptr >= 23) ? 0 : ptr + 1;
+			break;
+		case 2:		// --
+			ptr = ((int32_t)ptr <= 0) ? 23 : ptr - 1;
+			break;
+		case 3:		// #0
+			ptr = 0;
+			break;
+	}
+}
+
+
+uint32_t mb86235_device::calc_ea(int md, int arx, int ary, int disp)
+{
+	uint32_t ea = 0;
+
+	switch (md)
+	{
+		case 0x0:	// @ARx
+			ea = m_core->ar[arx];
+			break;
+		case 0x1:	// @ARx++
+			ea = m_core->ar[arx];
+			m_core->ar[arx]++;
+			break;
+		case 0x2:	// @ARx--
+			ea = m_core->ar[arx];
+			m_core->ar[arx]--;
+			break;
+		case 0x3:	// @ARx++disp
+			ea = m_core->ar[arx];
+			m_core->ar[arx] += disp;
+			break;
+		case 0x4:	// @ARx+ARy
+			ea = m_core->ar[arx] + m_core->ar[ary];
+			break;
+		case 0x5:	// @ARx+ARy++
+			ea = m_core->ar[arx] + m_core->ar[ary];
+			m_core->ar[ary]++;
+			break;
+		case 0x6:	// @ARx+ARy--
+			ea = m_core->ar[arx] + m_core->ar[ary];
+			m_core->ar[ary]--;
+			break;
+		case 0xa:	// @ARx+disp12
+			ea = m_core->ar[arx] + disp;
+			break;
+
+		default:
+			fatalerror("calc_ea: md = %02X, PC = %08X", md, m_core->pc);
+			break;
+	}
+	return ea;
+}
+
+uint32_t mb86235_device::read_reg(int reg)
+{
+	switch (reg)
+	{
+		case 0x00: case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x07:
+			return m_core->ma[reg & 7];
+		case 0x08: case 0x09: case 0x0a: case 0x0b: case 0x0c: case 0x0d: case 0x0e: case 0x0f:
+			return m_core->aa[reg & 7];
+		case 0x18: case 0x19: case 0x1a: case 0x1b: case 0x1c: case 0x1d: case 0x1e: case 0x1f:
+			return m_core->ar[reg & 7];
+		case 0x20: case 0x21: case 0x22: case 0x23: case 0x24: case 0x25: case 0x26: case 0x27:
+			return m_core->mb[reg & 7];
+		case 0x28: case 0x29: case 0x2a: case 0x2b: case 0x2c: case 0x2d: case 0x2e: case 0x2f:
+			return m_core->ab[reg & 7];
+
+		case 0x15:	// ST
+			return m_core->st;
+
+		case 0x30:	// PR
+			return m_core->pr[m_core->prp % 24];
+
+		case 0x31:	// FI
+			return read_fifo_in();
+
+		default:
+			fatalerror("read_reg: unimplemented register %02X at %08X", reg, m_core->pc);
+	}
+	return 0;
+}
+
+void mb86235_device::write_reg(int reg, uint32_t data)
+{
+	switch (reg)
+	{
+		case 0x00: case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x07:
+			m_core->ma[reg & 7] = data;
+			break;
+		case 0x08: case 0x09: case 0x0a: case 0x0b: case 0x0c: case 0x0d: case 0x0e: case 0x0f:
+			m_core->aa[reg & 7] = data;
+			break;
+		case 0x10:	m_core->eb = data; break;		// EB
+		case 0x13:	m_core->eo = data; break;		// EO
+		case 0x14:	m_core->sp = data; break;		// SP
+		case 0x15:	m_core->st = data; break;		// ST
+		case 0x18: case 0x19: case 0x1a: case 0x1b: case 0x1c: case 0x1d: case 0x1e: case 0x1f:
+			m_core->ar[reg & 7] = data;
+			break;
+		case 0x20: case 0x21: case 0x22: case 0x23: case 0x24: case 0x25: case 0x26: case 0x27:
+			m_core->mb[reg & 7] = data;
+			break;
+		case 0x28: case 0x29: case 0x2a: case 0x2b: case 0x2c: case 0x2d: case 0x2e: case 0x2f:
+			m_core->ab[reg & 7] = data;
+			break;
+		case 0x30:	m_core->pr[m_core->pwp % 24] = data; break;		// PR
+		case 0x32:	write_fifo_out0(data); break;					// FO0
+		case 0x34:	m_core->pdr = data; break;						// PDR
+		case 0x35:	m_core->ddr = data; break;						// DDR
+		case 0x36:	m_core->prp = data; break;						// PRP
+		case 0x37:	m_core->pwp = data; break;						// PWP
+
+		default:
+			fatalerror("write_reg: unimplemented register %02X at %08X", reg, m_core->pc);
+	}
+}
+
+uint32_t mb86235_device::read_alumul_input(int reg, bool fp, bool mul)
+{
+	switch (reg)
+	{
+		case 0x00: case 0x01: case 0x02: case 0x03: case 0x04: case 0x05: case 0x06: case 0x07:
+			return mul ? m_core->ma[reg & 7] : m_core->aa[reg & 7];
+		case 0x08: case 0x09: case 0x0a: case 0x0b: case 0x0c: case 0x0d: case 0x0e: case 0x0f:
+			return mul ? m_core->mb[reg & 7] : m_core->ab[reg & 7];
+
+		case 0x10:	// PR
+		case 0x11:	// PR++
+		case 0x12:	// PR--
+		case 0x13:	// PR#0
+			return m_core->pr[m_core->prp % 24];
+
+		case 0x18:	return fp ? 0xbf800000 : 0;				// 0 / -1.0E+0
+		case 0x19:	return fp ? 0 : 1;						// 1 / 0.0E+0
+		case 0x1a:	return fp ? 0x3f000000 : 0xffffffff;	// -1 / 0.5+0
+		case 0x1b:	return 0x3f800000;						// 1.0E+0
+		case 0x1c:	return 0x3fc00000;						// 1.5E+0
+		case 0x1d:	return 0x40000000;						// 2.0E+0
+		case 0x1e:	return 0x40400000;						// 3.0E+0
+		case 0x1f:	return 0x40a00000;						// 5.0E+0
+
+		default:
+			fatalerror("read_alumul_input: invalid register %02X", reg);
+	}
+	return 0;
+}
+
+uint32_t *mb86235_device::alu_output(int reg)
+{
+	switch (reg >> 3)
+	{
+		case 0:		return &m_core->ma[reg & 7];
+		case 1:		return &m_core->mb[reg & 7];
+		case 2:		return &m_core->aa[reg & 7];
+		default:	return &m_core->ab[reg & 7];
+	}
+}
+
+
+void mb86235_device::execute_alu(const decoded_op &op, uint32_t *dst)
+{
+	int i1 = (op.aluop >> 10) & 0xf;
+	int i2 = (op.aluop >> 5) & 0x1f;
+	int aluop = (op.aluop >> 14) & 0x1f;
+
+	uint32_t alu1 = (i1 & 8) ? m_core->ab[i1 & 7] : m_core->aa[i1 & 7];
+	uint32_t mask, flags = 0;
+	bool overflow;
+
+	switch (aluop)
+	{
+		case 0x00:		// FADD
+		{
+			float r = u2f(read_alumul_input(i2, true, false)) + u2f(alu1);
+			*dst = f2u(r);
+			mask = ST_AN | ST_AZ;
+			flags = float_flags(r, ST_AN, ST_AZ);
+			break;
+		}
+
+		case 0x02:		// FSUB
+		{
+			float r = u2f(read_alumul_input(i2, true, false)) - u2f(alu1);
+			*dst = f2u(r);
+			mask = ST_AN | ST_AZ;
+			flags = float_flags(r, ST_AN, ST_AZ);
+			break;
+		}
+
+		case 0x04:		// FCMP
+		{
+			float a = u2f(read_alumul_input(i2, true, false));
+			float b = u2f(alu1);
+			mask = ST_AN | ST_AZ;
+			flags = ((a < b) ? ST_AN : 0) | ((a == b) ? ST_AZ : 0);
+			break;
+		}
+
+		case 0x05:		// FABS
+			*dst = alu1 & 0x7fffffff;
+			mask = ST_AN | ST_AZ;
+			flags = (*dst == 0) ? ST_AZ : 0;		// AN is always cleared
+			break;
+
+		case 0x06:		// FABC
+		{
+			float a = u2f(read_alumul_input(i2, true, false) & 0x7fffffff);
+			float b = u2f(alu1 & 0x7fffffff);
+			mask = ST_AN | ST_AZ | ST_AU;
+			flags = ((a < b) ? ST_AN : 0) | ((a == b) ? ST_AZ : 0) | ST_AU;
+			break;
+		}
+
+		case 0x07:		// NOP
+			return;
+
+		case 0x0a:		// FRCP
+		{
+			float r = 1.0f / u2f(alu1);
+			*dst = f2u(r);
+			mask = ST_AN | ST_AZ;
+			flags = float_flags(r, ST_AN, ST_AZ);
+			break;
+		}
+
+		case 0x0b:		// FRSQ
+			*dst = f2u(1.0f / sqrtf(u2f(alu1)));
+			mask = ST_AN | ST_AZ;					// AN and AZ are always cleared
+			break;
+
+		case 0x0d:		// CIF
+		{
+			uint32_t v = read_alumul_input(i1, true, false);
+			*dst = f2u((float)(int32_t)v);
+			mask = ST_AN | ST_AZ;
+			flags = int_flags(v, ST_AN, ST_AZ);
+			break;
+		}
+
+		case 0x0e:		// CFI
+		{
+			float f = u2f(alu1);
+			double d = (m_core->mod & 0x80) ? nearbyint(f) : trunc(f);
+			if (d < -2147483648.0) d = -2147483648.0;
+			if (d > 2147483647.0) d = 2147483647.0;
+			uint32_t r = saturate24((uint32_t)(int32_t)d, overflow);
+			*dst = r;
+			mask = ST_AN | ST_AZ | (overflow ? ST_AV : 0);		// AV is only ever set here
+			flags = int_flags(r, ST_AN, ST_AZ) | ST_AV;
+			break;
+		}
+
+		case 0x10:		// ADD
+		{
+			uint32_t r = saturate24(read_alumul_input(i2, false, false) + alu1, overflow);
+			*dst = r;
+			mask = ST_AN | ST_AZ | (overflow ? ST_AV : 0);
+			flags = int_flags(r, ST_AN, ST_AZ) | ST_AV;
+			break;
+		}
+
+		case 0x12:		// SUB
+		{
+			uint32_t r = saturate24(read_alumul_input(i2, false, false) - alu1, overflow);
+			*dst = r;
+			mask = ST_AN | ST_AZ | (overflow ? ST_AV : 0);
+			flags = int_flags(r, ST_AN, ST_AZ) | ST_AV;
+			break;
+		}
+
+		case 0x14:		// CMP
+		{
+			uint32_t r = saturate24(read_alumul_input(i2, false, false) - alu1, overflow);
+			mask = ST_AN | ST_AZ | (overflow ? ST_AV : 0);
+			flags = int_flags(r, ST_AN, ST_AZ) | ST_AV;
+			break;
+		}
+
+		case 0x16:		// ATR
+			*dst = alu1;
+			return;
+
+		case 0x18:		// AND
+		{
+			uint32_t r = read_alumul_input(i2, false, false) & alu1;
+			*dst = r;
+			mask = ST_AN | ST_AZ | ST_AV | ST_AU;		// AV and AU are cleared
+			flags = int_flags(r, ST_AN, ST_AZ);
+			break;
+		}
+
+		case 0x1c:		// LSR
+		{
+			uint32_t r = read_alumul_input(i1, false, false) >> i2;
+			*dst = r;
+			mask = ST_AN | ST_AZ | ST_AV | ST_AU;		// AV and AU are cleared
+			flags = int_flags(r, ST_AN, ST_AZ);
+			break;
+		}
+
+		case 0x1d:		// LSL
+		{
+			uint32_t r = read_alumul_input(i1, false, false) << i2;
+			*dst = r;
+			mask = ST_AN | ST_AZ | ST_AV | ST_AU;		// AV and AU are cleared
+			flags = int_flags(r, ST_AN, ST_AZ);
+			break;
+		}
+
+		default:
+			m_core->pc = op.pc;
+			m_core->arg0 = aluop;
+			unimplemented_alu();
+			return;
+	}
+
+	m_core->st = (m_core->st & ~mask) | (flags & mask);
+}
+
+void mb86235_device::execute_mul(const decoded_op &op, uint32_t *dst)
+{
+	int i1 = (op.mulop >> 10) & 0xf;
+	int i2 = (op.mulop >> 5) & 0x1f;
+
+	uint32_t mul1 = (i1 & 8) ? m_core->mb[i1 & 7] : m_core->ma[i1 & 7];
+
+	if (op.mulop & 0x4000)
+	{
+		// FMUL
+		float r = u2f(mul1) * u2f(read_alumul_input(i2, true, true));
+		*dst = f2u(r);
+		m_core->st = (m_core->st & ~(ST_MN | ST_MZ)) | float_flags(r, ST_MN, ST_MZ);
+	}
+	else
+	{
+		// MUL
+		bool overflow;
+		uint32_t r = saturate24((uint32_t)((int32_t)read_alumul_input(i2, false, true) * (int64_t)(int32_t)mul1), overflow);
+		*dst = r;
+		m_core->st = (m_core->st & ~(ST_MN | ST_MZ)) | int_flags(r, ST_MN, ST_MZ) | (overflow ? ST_MV : 0);		// MV is only ever set here
+	}
+}
+
+
+bool mb86235_device::execute_control(const decoded_op &op, uint32_t condflags)
+{
+	// returns true for a taken branch, with the target in jmpdest
+	int ef1 = (op.opcode >> 16) & 0x3f;
+	int ef2 = op.opcode & 0xffff;
+	int cop = (op.opcode >> 22) & 0x1f;
+
+	static const uint32_t cond_flag[14] =
+	{
+		ST_MN, ST_MZ, ST_MV, ST_MU, ST_ZD, ST_NR, ST_IL, ST_ZC, ST_AN, ST_AZ, ST_AV, ST_AU, ST_MD, ST_AD
+	};
+
+	bool cond = false;
+	switch (cop)
+	{
+		case 0x10:		// DBcc
+		case 0x11:		// DBNcc
+		case 0x18:		// DCcc
+		case 0x19:		// DCNcc
+			if (ef1 > 0x0d)
+				fatalerror("execute_control: unimplemented cc %02X at %08X", ef1, op.pc);
+			cond = (condflags & cond_flag[ef1]) != 0;
+			if (cop & 1)
+				cond = !cond;
+			break;
+	}
+
+	switch (cop)
+	{
+		case 0x00:		// NOP
+			return false;
+
+		case 0x01:		// REP
+			m_core->rpc = (ef1 != 0) ? m_core->ar[ef2 >> 13] : ef2;
+			m_core->st |= ST_RP;
+			return false;
+
+		case 0x02:		// SETL
+			m_core->lpc = (ef1 != 0) ? m_core->ar[ef2 >> 13] : ef2;
+			m_core->st |= ST_LP;
+			return false;
+
+		case 0x03:
+			if (ef1 & 1)	// CLRFI
+			{
+				m_core->fifoin.num = 0;
+				m_core->fifoin.rpos = 0;
+				m_core->fifoin.wpos = 0;
+			}
+			if (ef1 & 2)	// CLRFO
+			{
+				m_core->fifoout0.num = 0;
+				m_core->fifoout0.rpos = 0;
+				m_core->fifoout0.wpos = 0;
+				m_core->fifoout1.num = 0;
+				m_core->fifoout1.rpos = 0;
+				m_core->fifoout1.wpos = 0;
+			}
+			return false;
+
+		case 0x08:		// SETM #imm16
+			m_core->mod = ef2;
+			return false;
+
+		case 0x10:		// DBcc
+		case 0x11:		// DBNcc
+		case 0x12:		// DJMP
+		case 0x18:		// DCcc
+		case 0x19:		// DCNcc
+		case 0x1a:		// DCALL
+			if (cop != 0x12 && cop != 0x1a && !cond)
+				return false;
+
+			if (op.targetpc != BRANCH_TARGET_DYNAMIC)
+				m_core->jmpdest = op.targetpc;
+			else
+			{
+				switch ((op.opcode >> 12) & 0xf)
+				{
+					case 0x2:	// ARx
+						m_core->jmpdest = m_core->ar[(ef2 >> 6) & 7];
+						break;
+					case 0x4:	// Axx
+						m_core->jmpdest = (ef2 & 0x400) ? m_core->ab[(ef2 >> 6) & 7] : m_core->aa[(ef2 >> 6) & 7];
+						break;
+					default:
+						fatalerror("execute_control: branch type %02X at %08X", (int)((op.opcode >> 12) & 0xf), op.pc);
+				}
+			}
+
+			if (cop >= 0x18)
+			{
+				// push the return address past the delay slot
+				if (m_core->pcs_ptr >= 4)
+				{
+					m_core->pc = op.pc;
+					pcs_overflow();
+				}
+				m_core->pcs[m_core->pcs_ptr++] = op.pc + 2;
+			}
+			return true;
+
+		case 0x1b:		// DRET
+			if (m_core->pcs_ptr <= 0)
+			{
+				m_core->pc = op.pc;
+				pcs_underflow();
+			}
+			m_core->jmpdest = m_core->pcs[--m_core->pcs_ptr];
+			return true;
+
+		case 0x13:		// DBLP
+			m_core->lpc--;
+			if ((int32_t)m_core->lpc <= 0)
+				return false;
+			m_core->jmpdest = op.targetpc;
+			return true;
+
+		default:
+			m_core->pc = op.pc;
+			m_core->arg0 = cop;
+			unimplemented_control();
+			return false;
+	}
+}
+
+
+void mb86235_device::execute_xfer1(const decoded_op &op)
+{
+	uint64_t opcode = op.opcode;
+
+	int dr = (opcode >> 12) & 0x7f;
+	int sr = (opcode >> 19) & 0x7f;
+	int md = opcode & 0xf;
+	int ary = (opcode >> 4) & 7;
+	int disp5 = (opcode >> 7) & 0x1f;
+	int trm = (opcode >> 26) & 1;
+	int dir = (opcode >> 25) & 1;
+
+	if (trm != 0)
+	{
+		// external transfer, to or from a register or the internal RAM
+		int32_t disp7 = sr;
+		if (disp7 & 0x40) disp7 |= 0xffffff80;
+
+		uint32_t addr = (m_core->eb + m_core->eo + disp7) << 2;
+		if (dir == 0)
+		{
+			uint32_t data;
+			if ((dr & 0x40) == 0)
+				data = read_reg(dr & 0x3f);
+			else
+			{
+				uint32_t ea = calc_ea(md, dr & 7, ary, disp5);
+				data = (dr & 0x20) ? m_datab->read_dword(ea << 2) : m_dataa->read_dword(ea << 2);
+			}
+			m_dataa->write_dword(addr, data);
+		}
+		else
+		{
+			uint32_t data = m_dataa->read_dword(addr);
+			if ((dr & 0x40) == 0)
+				write_reg(dr & 0x3f, data);
+			else
+			{
+				uint32_t ea = calc_ea(md, dr & 7, ary, disp5);
+				if (dr & 0x20)
+					m_datab->write_dword(ea << 2, data);
+				else
+					m_dataa->write_dword(ea << 2, data);
+			}
+		}
+
+		// update EO
+		m_core->eo += disp7;
+		return;
+	}
+
+	if (sr == 0x58)
+	{
+		// MOV1 #imm12, DR
+		write_reg(dr & 0x3f, opcode & 0xfff);
+		return;
+	}
+
+	uint32_t data;
+	if ((sr & 0x40) == 0)
+		data = read_reg(sr & 0x3f);
+	else
+	{
+		uint32_t ea = calc_ea(md, sr & 7, ary, disp5);
+		data = (sr & 0x20) ? m_datab->read_dword(ea << 2) : m_dataa->read_dword(ea << 2);
+	}
+
+	if ((dr & 0x40) == 0)
+		write_reg(dr & 0x3f, data);
+	else
+	{
+		uint32_t ea = calc_ea(md, dr & 7, ary, disp5);
+		if (dr & 0x20)
+			m_datab->write_dword(ea << 2, data);
+		else
+			m_dataa->write_dword(ea << 2, data);
+	}
+}
+
+uint32_t mb86235_device::double_xfer_source(int sd, int reg, int md, int arx, int ary, int bank)
+{
+	if (sd == 2)	// RAM -> reg
+	{
+		uint32_t ea = calc_ea(md, arx, ary, 0);
+		return bank ? m_datab->read_dword(ea << 2) : m_dataa->read_dword(ea << 2);
+	}
+	return read_reg(reg);
+}
+
+void mb86235_device::double_xfer_dest(int sd, int reg, int md, int arx, int ary, int bank, uint32_t data)
+{
+	if (sd == 1)	// reg -> RAM
+	{
+		uint32_t ea = calc_ea(md, arx, ary, 0);
+		if (bank)
+			m_datab->write_dword(ea << 2, data);
+		else
+			m_dataa->write_dword(ea << 2, data);
+	}
+	else
+		write_reg(reg, data);
+}
+
+void mb86235_device::execute_double_xfer1(const decoded_op &op)
+{
+	uint64_t opcode = op.opcode;
+
+	int sd = (opcode >> 25) & 3;
+	int md = opcode & 0xf;
+
+	// both buses move at once, so both sources are read before either destination is written
+	if (sd == 0)
+	{
+		uint32_t adata = read_reg((opcode >> 20) & 0x1f);
+		uint32_t bdata = read_reg((opcode >> 10) & 0x1f);
+		write_reg((opcode >> 5) & 0x1f, bdata);
+		write_reg((opcode >> 15) & 0x1f, adata);
+	}
+	else if (sd != 3)
+	{
+		int areg = (opcode >> 20) & 0x1f;
+		int aarx = (opcode >> 17) & 7;
+		int aary = (opcode >> 14) & 7;
+		int breg = (opcode >> 10) & 0xf;
+		int barx = (opcode >> 7) & 7;
+		int bary = (opcode >> 4) & 7;
+
+		uint32_t adata = double_xfer_source(sd, areg, md, aarx, aary, 0);
+		uint32_t bdata = double_xfer_source(sd, breg, md, barx, bary, 1);
+		double_xfer_dest(sd, breg, md, barx, bary, 1, bdata);
+		double_xfer_dest(sd, areg, md, aarx, aary, 0, adata);
+	}
+	else
+	{
+		m_core->pc = op.pc;
+		m_core->arg64 = opcode;
+		unimplemented_double_xfer1();
+	}
+}
+
+void mb86235_device::execute_double_xfer2(const decoded_op &op)
+{
+	uint64_t opcode = op.opcode;
+
+	int asd = (opcode >> 38) & 3;
+	int bsd = (opcode >> 18) & 3;
+
+	if (asd == 3)
+	{
+		// MOVI
+		m_core->pc = op.pc;
+		m_core->arg64 = opcode;
+		unimplemented_double_xfer2();
+		return;
+	}
+
+	uint32_t afield = (opcode >> 20) & 0x3ffff;
+	uint32_t bfield = opcode & 0x3ffff;
+
+	int as = (afield >> 13) & 0x1f;
+	int ad = (asd == 0) ? ((afield >> 8) & 0x1f) : as;
+	int bs = (bfield >> 13) & 0x1f;
+	int bd = (bsd == 0) ? ((bfield >> 8) & 0x1f) : bs;
+
+	uint32_t adata = double_xfer_source(asd, as, afield & 0xf, (afield >> 10) & 7, (afield >> 7) & 7, 0);
+	uint32_t bdata = double_xfer_source(bsd, bs, bfield & 0xf, (bfield >> 10) & 7, (bfield >> 7) & 7, 1);
+	double_xfer_dest(bsd, bd, bfield & 0xf, (bfield >> 10) & 7, (bfield >> 7) & 7, 1, bdata);
+	double_xfer_dest(asd, ad, afield & 0xf, (afield >> 10) & 7, (afield >> 7) & 7, 0, adata);
+}
+
+void mb86235_device::execute_xfer2(const decoded_op &op)
+{
+	uint64_t opcode = op.opcode;
+
+	int xop = (opcode >> 39) & 3;
+	int trm = (opcode >> 38) & 1;
+	int dir = (opcode >> 37) & 1;
+	int sr = (opcode >> 31) & 0x7f;
+	int dr = (opcode >> 24) & 0x7f;
+	int ary = (opcode >> 4) & 7;
+	int md = opcode & 0xf;
+
+	int disp14 = (opcode >> 7) & 0x3fff;
+	if (disp14 & 0x2000) disp14 |= 0xffffc000;
+
+	if (xop == 2)	// MOV4
+	{
+		uint32_t &icdtr = m_core->icdtr[dr & 7];
+
+		if (trm != 0)
+		{
+			// external transfer
+			uint32_t addr = (m_core->eb + m_core->eo + disp14) << 2;
+			if (dir == 0)
+				m_dataa->write_dword(addr, icdtr);
+			else
+				icdtr = m_dataa->read_dword(addr);
+			m_core->eo += disp14;
+		}
+		else if (sr == 0x58)
+			icdtr = opcode & 0xffffff;
+		else if ((sr & 0x40) == 0)
+			icdtr = read_reg(sr & 0x3f);
+		else
+		{
+			uint32_t ea = calc_ea(md, sr & 7, ary, disp14);
+			icdtr = (sr & 0x20) ? m_datab->read_dword(ea << 2) : m_dataa->read_dword(ea << 2);
+		}
+		return;
+	}
+	if (xop != 0)
+		return;
+
+	if (trm != 0)
+	{
+		// external transfer
+		uint32_t addr = (m_core->eb + m_core->eo + disp14) << 2;
+		if (dir == 0)
+			m_dataa->write_dword(addr, read_reg(dr & 0x3f));
+		else
+			write_reg(dr & 0x3f, m_dataa->read_dword(addr));
+
+		// update EO
+		m_core->eo += disp14;
+		return;
+	}
+
+	if (sr == 0x58)
+	{
+		// MOV2 #imm24, DR
+		write_reg(dr & 0x3f, opcode & 0xffffff);
+		return;
+	}
+
+	uint32_t data;
+	if ((sr & 0x40) == 0)
+		data = read_reg(sr & 0x3f);
+	else
+	{
+		uint32_t ea = calc_ea(md, sr & 7, ary, disp14);
+		data = (sr & 0x20) ? m_datab->read_dword(ea << 2) : m_dataa->read_dword(ea << 2);
+	}
+
+	if ((dr & 0x40) == 0)
+		write_reg(dr & 0x3f, data);
+	else
+	{
+		uint32_t ea = calc_ea(md, dr & 7, ary, disp14);
+		if (dr & 0x20)
+			m_datab->write_dword(ea << 2, data);
+		else
+			m_dataa->write_dword(ea << 2, data);
+	}
+}
+
+void mb86235_device::execute_xfer3(const decoded_op &op)
+{
+	uint64_t opcode = op.opcode;
+
+	uint32_t imm = (uint32_t)(opcode >> 27);
+	int dr = (opcode >> 19) & 0x7f;
+	int ary = (opcode >> 4) & 7;
+	int md = opcode & 0xf;
+
+	int disp = (opcode >> 7) & 0xfff;
+	if (disp & 0x800) disp |= 0xfffff800;
+
+	switch (dr >> 5)
+	{
+		case 0:
+		case 1:		// reg
+			write_reg(dr & 0x3f, imm);
+			break;
+
+		case 2:		// RAM-A
+			m_dataa->write_dword(calc_ea(md, dr & 7, ary, disp) << 2, imm);
+			break;
+
+		case 3:		// RAM-B
+			m_datab->write_dword(calc_ea(md, dr & 7, ary, disp) << 2, imm);
+			break;
+	}
+}